@@ -0,0 +1,50 @@
+/* Global heap accounting for the benchmark programs.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/* Replaces the global operator new and operator delete, so it must be
+ * included by exactly one translation unit of the program. Each block is
+ * preceded by a header of sizeof(std::max_align_t) bytes holding its size.
+ * Counting is not thread safe. operator delete is kept out of line, as
+ * otherwise GCC sees the header read as out of the bounds of the object
+ * being deleted (-Warray-bounds).
+ */
+
+inline std::size_t allocated=0,peak_allocated=0,num_allocations=0;
+
+void* operator new(std::size_t n)
+{
+  constexpr auto header=sizeof(std::max_align_t);
+  auto p=static_cast<unsigned char*>(std::malloc(n+header));
+  if(!p)throw std::bad_alloc{};
+  *reinterpret_cast<std::size_t*>(p)=n;
+  allocated+=n;
+  peak_allocated=(std::max)(peak_allocated,allocated);
+  ++num_allocations;
+  return p+header;
+}
+
+BOOST_NOINLINE void operator delete(void* p)noexcept
+{
+  if(!p)return;
+  auto q=static_cast<unsigned char*>(p)-sizeof(std::max_align_t);
+  allocated-=*reinterpret_cast<std::size_t*>(q);
+  std::free(q);
+}
+
+void operator delete(void* p,std::size_t)noexcept{operator delete(p);}
+
+#endif
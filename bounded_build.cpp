@@ -0,0 +1,125 @@
+/* Construction time, bumped fraction and lookup time of hd::perfect_set
+ * with bounded-time construction, for several trial budgets and lambdas.
+ * Builds are timed once, as unbounded ones can take minutes.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "hd_perfect_set.hpp"
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+template<typename Data,typename... Args>
+void test(
+  const Data& data,const Data& queries,const char* budget,Args... args)
+{
+  using container=hd::perfect_set<typename Data::value_type,hd::mulx_hash>;
+
+  auto      n=data.size();
+  auto      t=std::chrono::high_resolution_clock::now();
+  container c(data.begin(),data.end(),args...);
+  auto      build=std::chrono::duration<double>(
+              std::chrono::high_resolution_clock::now()-t).count();
+  auto      stats=c.stats();
+
+  if(find_all{}(data.begin(),data.end(),c)!=n){
+    std::cerr<<"element not found"<<std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::cout
+    <<n<<";"<<stats.lambda<<";"<<budget<<";"
+    <<build*1E9/n<<";"<<stats.bumped_fraction()*100<<";"
+    <<measure([&]{
+        return find_all{}(queries.begin(),queries.end(),c);
+      })*1E9/queries.size()<<";"
+    <<std::endl;
+}
+
+int main(int argc,char* argv[])
+{
+  /* bounded_build [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):1'000'000;
+
+  using value_type=std::size_t;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data,queries;
+
+  std::cout
+    <<"n;lambda;max trials;build (ns/elem);bumped (%);lookup (ns);"
+    <<std::endl;
+  for(std::size_t n=10'000;n<=max_n;n*=10){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    queries.clear();
+    for(std::size_t i=0;i<1'000'000;++i)queries.push_back(data[dist(gen)%n]);
+
+    test(data,queries,"unbounded");
+    for(std::size_t lambda:{4,8,16}){
+      for(std::size_t max_trials:{256,4096,65536}){
+        test(
+          data,queries,std::to_string(max_trials).c_str(),
+          hd::bounded_construction{max_trials},lambda);
+      }
+    }
+  }
+}
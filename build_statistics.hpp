@@ -0,0 +1,400 @@
+/* Structured construction statistics and build quality reports for
+ * perfect sets and hash functions.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef BUILD_STATISTICS_HPP
+#define BUILD_STATISTICS_HPP
+
+#include <algorithm>
+#include <boost/core/bit.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace hd{
+
+enum class build_phase
+{
+  hashing,    /* computing the hash of every element */
+  bucketing,  /* grouping elements by bucket, detecting duplicates */
+  sorting,    /* ordering buckets for placement */
+  placement,  /* searching displacements for buckets of 2+ elements */
+  singletons  /* placing buckets of 1 element */
+};
+
+static constexpr std::size_t num_build_phases=5;
+
+inline const char* build_phase_name(build_phase p)
+{
+  static const char* names[]={
+    "hashing","bucketing","sorting","placement","singletons"};
+  return names[static_cast<std::size_t>(p)];
+}
+
+enum class build_failure_reason
+{
+  none,
+  bucket_unplaceable, /* no displacement found for some bucket */
+  duplicate_element,
+  duplicate_hash
+};
+
+inline const char* build_failure_reason_name(build_failure_reason r)
+{
+  static const char* names[]={
+    "none","bucket unplaceable","duplicate element","duplicate hash"};
+  return names[static_cast<std::size_t>(r)];
+}
+
+/* Passed to build_statistics::on_progress on entering a phase and then
+ * every progress_interval buckets during placement and singletons.
+ * Buckets are counted in placement order across both phases.
+ */
+
+struct build_progress
+{
+  build_phase phase;
+  std::size_t lambda;
+  std::size_t buckets_done,num_buckets;
+  std::size_t elements_done,num_elements;
+};
+
+/* Displacement trials spent on the buckets of a given size. bins[i]
+ * counts the buckets placed after more than 2^(i-1) and at most 2^i
+ * trials (bins[0]: at the first trial).
+ */
+
+struct trial_histogram
+{
+  static constexpr std::size_t num_bins=48;
+
+  void add(std::uint64_t trials)
+  {
+    ++buckets;
+    total_trials+=trials;
+    max_trials=(std::max)(max_trials,trials);
+    ++bins[(std::min)(
+      static_cast<std::size_t>(boost::core::bit_width(trials?trials-1:0)),
+      num_bins-1)];
+  }
+
+  double mean_trials()const
+  {
+    return buckets?static_cast<double>(total_trials)/buckets:0.0;
+  }
+
+  std::size_t   buckets=0;
+  std::uint64_t total_trials=0,max_trials=0;
+  std::uint64_t bins[num_bins]={};
+};
+
+/* one construction attempt, i.e. one value of lambda */
+
+struct build_attempt
+{
+  double seconds()const
+  {
+    double res=0;
+    for(auto s:phase_seconds)res+=s;
+    return res;
+  }
+
+  std::size_t                  lambda=0;
+  std::size_t                  num_elements=0,num_buckets=0;
+  bool                         succeeded=false;
+  build_failure_reason         failure=build_failure_reason::none;
+  std::size_t                  failed_bucket_size=0;
+  std::uint64_t                failed_bucket_trials=0;
+  std::size_t                  bumped_buckets=0,bumped_elements=0;
+  double                       phase_seconds[num_build_phases]={};
+  std::vector<trial_histogram> trials; /* indexed by bucket size */
+};
+
+/* Passed into construction, which appends an attempt per lambda tried
+ * (in the order tried). Phase timings are only taken when a
+ * build_statistics object is given, so construction without one costs
+ * the same as before.
+ */
+
+struct build_statistics
+{
+  std::size_t lambda_retries()const
+  {
+    return attempts.empty()?0:attempts.size()-1;
+  }
+
+  bool succeeded()const
+  {
+    return !attempts.empty()&&attempts.back().succeeded;
+  }
+
+  double seconds()const
+  {
+    double res=0;
+    for(const auto& a:attempts)res+=a.seconds();
+    return res;
+  }
+
+  void print(std::ostream& os)const
+  {
+    for(const auto& a:attempts){
+      os<<"lambda "<<a.lambda<<": "<<a.num_elements<<" elements, "
+        <<a.num_buckets<<" buckets, ";
+      if(a.succeeded)os<<"succeeded";
+      else{
+        os<<"failed ("<<build_failure_reason_name(a.failure);
+        if(a.failure==build_failure_reason::bucket_unplaceable){
+          os<<": size "<<a.failed_bucket_size<<", "
+            <<a.failed_bucket_trials<<" trials";
+        }
+        os<<")";
+      }
+      os<<" in "<<a.seconds()<<" s\n";
+      if(a.bumped_buckets){
+        os<<"  bumped: "<<a.bumped_buckets<<" buckets, "
+          <<a.bumped_elements<<" elements\n";
+      }
+      for(std::size_t p=0;p<num_build_phases;++p){
+        os<<"  "<<build_phase_name(static_cast<build_phase>(p))<<": "
+          <<a.phase_seconds[p]<<" s\n";
+      }
+      os<<"  bucket size;buckets;mean trials;max trials;\n";
+      for(std::size_t n=0;n<a.trials.size();++n){
+        const auto& t=a.trials[n];
+        if(!t.buckets)continue;
+        os<<"  "<<n<<";"<<t.buckets<<";"<<t.mean_trials()<<";"
+          <<t.max_trials<<";\n";
+      }
+    }
+  }
+
+  std::function<void(const build_progress&)> on_progress;
+  std::size_t                                progress_interval=10000;
+  std::vector<build_attempt>                 attempts;
+};
+
+/* Build quality of a constructed container, as returned by its stats()
+ * member function. Displacement parameters, (d0,d1) for HD(C) containers
+ * and (shift,width) for FKS ones, are only reported for the buckets of 2+
+ * elements, whose parameters are found by search: high maxima relative to
+ * the means, or lambda below the one requested, point to a hasher and key
+ * set close to construction failure.
+ */
+
+struct space_component
+{
+  const char* name;
+  std::size_t bits;
+};
+
+struct build_quality
+{
+  void add_bucket(std::size_t size,std::size_t p0=0,std::size_t p1=0)
+  {
+    if(bucket_sizes.size()<=size)bucket_sizes.resize(size+1);
+    ++bucket_sizes[size];
+    if(size<2)return;
+    ++searched_buckets;
+    std::size_t p[2]={p0,p1};
+    for(std::size_t i=0;i<2;++i){
+      max_parameters[i]=(std::max)(max_parameters[i],p[i]);
+      parameter_sums[i]+=static_cast<double>(p[i]);
+    }
+  }
+
+  /* bucket moved to the overflow table in bounded-time construction */
+
+  void add_bumped_bucket(std::size_t size)
+  {
+    if(bucket_sizes.size()<=size)bucket_sizes.resize(size+1);
+    ++bucket_sizes[size];
+    ++bumped_buckets;
+    bumped_elements+=size;
+  }
+
+  double bumped_fraction()const
+  {
+    return num_elements?static_cast<double>(bumped_elements)/num_elements:0.0;
+  }
+
+  double mean_parameter(std::size_t i)const
+  {
+    return searched_buckets?parameter_sums[i]/searched_buckets:0.0;
+  }
+
+  double empty_bucket_fraction()const
+  {
+    return num_buckets&&!bucket_sizes.empty()?
+      static_cast<double>(bucket_sizes[0])/num_buckets:0.0;
+  }
+
+  double bits_per_key(const space_component& c)const
+  {
+    return num_elements?static_cast<double>(c.bits)/num_elements:0.0;
+  }
+
+  double bits_per_key()const
+  {
+    double res=0;
+    for(const auto& c:space)res+=bits_per_key(c);
+    return res;
+  }
+
+  void print(std::ostream& os)const
+  {
+    os<<"lambda "<<lambda<<": "<<num_elements<<" elements, "
+      <<num_buckets<<" buckets ("<<empty_bucket_fraction()*100
+      <<"% empty)\n";
+    os<<"  bucket size;buckets;\n";
+    for(std::size_t n=0;n<bucket_sizes.size();++n){
+      if(bucket_sizes[n])os<<"  "<<n<<";"<<bucket_sizes[n]<<";\n";
+    }
+    for(std::size_t i=0;i<2;++i){
+      os<<"  "<<parameter_names[i]<<": max "<<max_parameters[i]
+        <<", mean "<<mean_parameter(i)<<"\n";
+    }
+    if(bumped_buckets){
+      os<<"  bumped: "<<bumped_buckets<<" buckets, "<<bumped_elements
+        <<" elements ("<<bumped_fraction()*100<<"%)\n";
+    }
+    if(window_slots){
+      os<<"  element window gaps: "<<window_gaps<<" of "<<window_slots
+        <<" slots\n";
+    }
+    for(const auto& c:space){
+      os<<"  "<<c.name<<": "<<bits_per_key(c)<<" bits/key\n";
+    }
+    os<<"  total: "<<bits_per_key()<<" bits/key\n";
+  }
+
+  std::size_t                  lambda=0; /* as used, i.e. after retries */
+  std::size_t                  num_elements=0,num_buckets=0;
+  std::vector<std::size_t>     bucket_sizes; /* buckets by element count */
+  const char*                  parameter_names[2]={"",""};
+  std::size_t                  searched_buckets=0;
+  std::size_t                  max_parameters[2]={};
+  double                       parameter_sums[2]={};
+  std::size_t                  bumped_buckets=0,bumped_elements=0;
+
+  /* FKS only: the 2^width element slots addressable by the buckets of 2+
+   * elements, and those of them not taken by the bucket (the element
+   * array itself has no gaps)
+   */
+
+  std::size_t                  window_slots=0,window_gaps=0;
+  std::vector<space_component> space;
+};
+
+/* Used by the construction code: does nothing if given no statistics. */
+
+class build_recorder
+{
+public:
+  build_recorder(
+    build_statistics* stats_,std::size_t lambda,std::size_t num_elements,
+    std::size_t num_buckets):
+    stats{stats_}
+  {
+    if(!stats)return;
+    stats->attempts.emplace_back();
+    attempt().lambda=lambda;
+    attempt().num_elements=num_elements;
+    attempt().num_buckets=num_buckets;
+  }
+
+  build_recorder(const build_recorder&)=delete;
+  ~build_recorder(){stop();}
+
+  void phase(build_phase p)
+  {
+    if(!stats)return;
+    stop();
+    current=static_cast<std::size_t>(p);
+    start=clock::now();
+    notify();
+  }
+
+  void trials(std::size_t bucket_size,std::uint64_t n)
+  {
+    if(!stats)return;
+    auto& t=attempt().trials;
+    if(t.size()<=bucket_size)t.resize(bucket_size+1);
+    t[bucket_size].add(n);
+  }
+
+  void progress(std::size_t buckets_done_,std::size_t elements_done_)
+  {
+    if(!stats)return;
+    buckets_done=buckets_done_;
+    elements_done=elements_done_;
+    if(stats->progress_interval&&buckets_done&&
+       buckets_done%stats->progress_interval==0)notify();
+  }
+
+  /* bucket given up on in bounded-time construction */
+
+  void bump(std::size_t bucket_size)
+  {
+    if(!stats)return;
+    ++attempt().bumped_buckets;
+    attempt().bumped_elements+=bucket_size;
+  }
+
+  void succeed()
+  {
+    if(!stats)return;
+    stop();
+    attempt().succeeded=true;
+  }
+
+  void fail(
+    build_failure_reason r,
+    std::size_t bucket_size=0,std::uint64_t bucket_trials=0)
+  {
+    if(!stats)return;
+    stop();
+    attempt().failure=r;
+    attempt().failed_bucket_size=bucket_size;
+    attempt().failed_bucket_trials=bucket_trials;
+  }
+
+private:
+  using clock=std::chrono::steady_clock;
+  static constexpr std::size_t no_phase=std::size_t(-1);
+
+  build_attempt& attempt(){return stats->attempts.back();}
+
+  void stop()
+  {
+    if(!stats||current==no_phase)return;
+    attempt().phase_seconds[current]+=
+      std::chrono::duration<double>(clock::now()-start).count();
+    current=no_phase;
+  }
+
+  void notify()
+  {
+    if(!stats->on_progress)return;
+    stats->on_progress({
+      static_cast<build_phase>(current),attempt().lambda,
+      buckets_done,attempt().num_buckets,
+      elements_done,attempt().num_elements});
+  }
+
+  build_statistics* stats;
+  std::size_t       current=no_phase;
+  std::size_t       buckets_done=0,elements_done=0;
+  clock::time_point start;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,270 @@
+/* Coroutine-based lookups for software-pipelined (interleaved) probing.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef CORO_LOOKUP_HPP
+#define CORO_LOOKUP_HPP
+
+#include <boost/config.hpp>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace hd{
+
+BOOST_FORCEINLINE void prefetch(const void* p)
+{
+#if defined(__GNUC__)||defined(__clang__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+/* Per-thread free lists of coroutine frames in 64-byte size classes, so
+ * that a lookup doesn't cost a trip to the general allocator. Frames
+ * larger than max_size are not pooled, and at most max_cached frames are
+ * kept per size class (frames freed by a thread other than the allocating
+ * one go to the freeing thread's lists). Cached frames are released on
+ * thread exit.
+ */
+
+struct coroutine_frame_pool
+{
+  static constexpr std::size_t granularity=64;
+  static constexpr std::size_t max_size=512;
+  static constexpr std::size_t max_cached=256;
+
+  static void* allocate(std::size_t n)
+  {
+    if(n>max_size)return ::operator new(n);
+    auto i=size_class(n);
+    if(auto p=cache_.heads[i]){
+      cache_.heads[i]=*static_cast<void**>(p);
+      --cache_.counts[i];
+      return p;
+    }
+    return ::operator new(i*granularity);
+  }
+
+  static void deallocate(void* p,std::size_t n)noexcept
+  {
+    if(n>max_size){
+      ::operator delete(p);
+      return;
+    }
+    auto i=size_class(n);
+    if(BOOST_UNLIKELY(cache_.state!=open)){
+      if(cache_.state==closed||!open_cache()){
+        ::operator delete(p);
+        return;
+      }
+    }
+    if(cache_.counts[i]==max_cached){
+      ::operator delete(p);
+      return;
+    }
+    *static_cast<void**>(p)=cache_.heads[i];
+    cache_.heads[i]=p;
+    ++cache_.counts[i];
+  }
+
+private:
+  static constexpr std::size_t num_classes=max_size/granularity+1;
+
+  enum cache_state:unsigned char{unused,open,closed};
+
+  struct cache
+  {
+    void*       heads[num_classes];
+    std::size_t counts[num_classes];
+    cache_state state;
+  };
+
+  /* frees the cached frames on thread exit, after which frames are
+   * deallocated directly (for instance, by thread_local objects destroyed
+   * later)
+   */
+
+  struct cache_owner
+  {
+    cache_owner(){cache_.state=open;}
+
+    ~cache_owner()
+    {
+      for(auto& head:cache_.heads){
+        while(head){
+          auto p=head;
+          head=*static_cast<void**>(p);
+          ::operator delete(p);
+        }
+      }
+      cache_.state=closed;
+    }
+  };
+
+  static std::size_t size_class(std::size_t n)
+  {
+    return (n+granularity-1)/granularity;
+  }
+
+  /* registers the owner on the first frame cached by the thread */
+
+  static BOOST_NOINLINE bool open_cache()noexcept
+  {
+    static thread_local cache_owner owner;
+    return cache_.state==open;
+  }
+
+  static inline thread_local cache cache_{};
+};
+
+/* Result of co_find: the lookup runs eagerly up to its first prefetch
+ * and suspends after every prefetch. resume() advances it to the next
+ * suspension point; once done(), get() returns the result. Keys are taken
+ * by reference and must outlive the lookup.
+ */
+
+template<typename Result>
+class lookup_task
+{
+public:
+  struct promise_type
+  {
+    lookup_task get_return_object()
+    {
+      return lookup_task{handle::from_promise(*this)};
+    }
+
+    std::suspend_never  initial_suspend()noexcept{return {};}
+    std::suspend_always final_suspend()noexcept{return {};}
+    void                return_value(Result x){res.emplace(std::move(x));}
+    void                unhandled_exception(){std::terminate();}
+
+    static void* operator new(std::size_t n)
+    {
+      return coroutine_frame_pool::allocate(n);
+    }
+
+    static void operator delete(void* p,std::size_t n)noexcept
+    {
+      coroutine_frame_pool::deallocate(p,n);
+    }
+
+    std::optional<Result> res;
+  };
+
+  lookup_task()=default;
+  lookup_task(lookup_task&& x)noexcept:h{std::exchange(x.h,{})}{}
+  ~lookup_task(){if(h)h.destroy();}
+
+  lookup_task& operator=(lookup_task&& x)noexcept
+  {
+    if(this!=&x){
+      if(h)h.destroy();
+      h=std::exchange(x.h,{});
+    }
+    return *this;
+  }
+
+  bool   done()const{return h.done();}
+  void   resume()const{h.resume();}
+  Result get()const{return *h.promise().res;}
+
+  /* runs the lookup to completion without interleaving */
+
+  Result run()const
+  {
+    while(!done())resume();
+    return get();
+  }
+
+private:
+  using handle=std::coroutine_handle<promise_type>;
+
+  explicit lookup_task(handle h_):h{h_}{}
+
+  handle h;
+};
+
+/* Interleaves up to Width in-flight lookups submitted from any number of
+ * call sites. Pending lookups are kept in a rotating queue: each step
+ * resumes the oldest one and, if not yet done, moves it to the back, so
+ * that Width-1 other lookups run between a prefetch and the access it
+ * prepares. When a lookup completes, f(tag,result) is called. Pending
+ * lookups are completed on destruction.
+ */
+
+template<typename Task,typename Callback,std::size_t Width=16>
+class lookup_scheduler
+{
+public:
+  static constexpr std::size_t width=Width;
+
+  explicit lookup_scheduler(Callback f_=Callback()):f(std::move(f_)){}
+  lookup_scheduler(const lookup_scheduler&)=delete;
+  ~lookup_scheduler(){flush();}
+
+  void submit(Task&& t,std::size_t tag)
+  {
+    if(t.done()){
+      f(tag,t.get());
+      return;
+    }
+    while(size==Width)step();
+    auto& s=slots[(head+size++)%Width];
+    s.task=std::move(t);
+    s.tag=tag;
+  }
+
+  /* completes all pending lookups */
+
+  void flush()
+  {
+    while(size)step();
+  }
+
+  std::size_t pending()const{return size;}
+
+private:
+  struct slot
+  {
+    Task        task;
+    std::size_t tag;
+  };
+
+  BOOST_FORCEINLINE void step()
+  {
+    auto  i=head;
+    auto& s=slots[i];
+    head=(head+1)%Width;
+    s.task.resume();
+    if(s.task.done()){
+      /* the slot is freed before f is called, as f may submit */
+
+      auto t=std::move(s.task);
+      auto tag=s.tag;
+      --size;
+      f(tag,t.get());
+    }
+    else{
+      auto j=(i+size)%Width; /* back of the queue */
+      if(j!=i)slots[j]=std::move(s);
+    }
+  }
+
+  Callback    f;
+  slot        slots[Width];
+  std::size_t head=0,size=0;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,44 @@
+/* Allocator accounting for the memory of the containers benchmarked.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+
+/* live bytes allocated through any counting_allocator */
+
+inline std::size_t allocated_bytes=0;
+
+template<typename T>
+struct counting_allocator
+{
+  using value_type=T;
+
+  counting_allocator()=default;
+  template<typename U>
+  counting_allocator(const counting_allocator<U>&){}
+
+  T* allocate(std::size_t n)
+  {
+    allocated_bytes+=n*sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p,std::size_t n)
+  {
+    allocated_bytes-=n*sizeof(T);
+    std::allocator<T>().deallocate(p,n);
+  }
+
+  bool operator==(const counting_allocator&)const{return true;}
+  bool operator!=(const counting_allocator&)const{return false;}
+};
+
+#endif
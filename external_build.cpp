@@ -0,0 +1,126 @@
+/* External-memory construction of hd::external_perfect_hash from key
+ * files, and lookup on the resulting memory-mapped file.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "hd_external_perfect_hash.hpp"
+
+struct position_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename PerfectHash>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const PerfectHash& ph)const
+  {
+    std::size_t res=0;
+    while(first!=last)res+=ph(*first++);
+    return res;
+  }
+};
+
+int main(int argc,char* argv[])
+{
+  /* external_build [n [keys_per_partition [dir]]] */
+
+  std::size_t n=argc>1?std::strtoull(argv[1],nullptr,10):10'000'000;
+  std::size_t keys_per_partition=
+    argc>2?std::strtoull(argv[2],nullptr,10):std::size_t(1)<<20;
+  std::filesystem::path dir=argc>3?
+    std::filesystem::path(argv[3]):
+    std::filesystem::temp_directory_path()/"external_build";
+  static constexpr std::size_t num_inputs=4;
+
+  std::filesystem::create_directories(dir);
+  std::vector<std::string> input_paths;
+  std::mt19937_64          gen(0);
+  for(std::size_t i=0;i<num_inputs;++i){
+    input_paths.push_back((dir/("keys-"+std::to_string(i))).string());
+    std::ofstream os(input_paths.back());
+    for(std::size_t j=i;j<n;j+=num_inputs){
+      os<<"key-"<<j<<"-"<<gen()%1000<<"\n";
+    }
+  }
+  auto output_path=(dir/"keys.phf").string();
+
+  auto t=std::chrono::high_resolution_clock::now();
+  hd::external_perfect_hash_builder<> builder(
+    input_paths,output_path,{.keys_per_partition=keys_per_partition});
+  builder.run();
+  auto build=std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now()-t).count();
+
+  hd::external_perfect_hash<> ph(output_path);
+  std::vector<std::string>    keys;
+  std::vector<bool>           taken(ph.size());
+  for(const auto& p:input_paths){
+    std::ifstream is(p);
+    std::string   line;
+    while(std::getline(is,line)){
+      auto pos=ph(line);
+      if(pos>=ph.size()||taken[pos]){
+        std::cerr<<"not a minimal perfect hash function"<<std::endl;
+        return EXIT_FAILURE;
+      }
+      taken[pos]=true;
+      if(keys.size()<1'000'000)keys.push_back(line);
+    }
+  }
+
+  std::cout
+    <<"n;partitions;build (ns/key);bits/key;lookup (ns);"<<std::endl
+    <<ph.size()<<";"<<(n+keys_per_partition-1)/keys_per_partition<<";"
+    <<build*1E9/ph.size()<<";"<<(double)ph.size_in_bits()/ph.size()<<";"
+    <<measure([&]{
+        return position_all{}(keys.begin(),keys.end(),ph);
+      })*1E9/keys.size()<<";"
+    <<std::endl;
+
+  std::filesystem::remove_all(dir);
+}
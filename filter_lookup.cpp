@@ -0,0 +1,192 @@
+/* Comparing keyless hd perfect filters against hd::perfect_set:
+ * construction time, memory, lookup time and false positive rate.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "hd_perfect_filter.hpp"
+#include "counting_allocator.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+struct contains_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.contains(*first++))++res;
+    }
+    return res;
+  }
+};
+
+/* bytes/elem doesn't include the out-of-line data of string elements */
+
+template<typename Data,typename Input,typename Make>
+void test(
+  const char* name,const Data& data,const Input& success,
+  const Input& failure,Make make)
+{
+  std::cout<<name<<":"<<std::endl;
+  std::cout
+    <<"n;build (ns/elem);bits/elem;"
+    <<"successful lookup (ns);unsuccessful lookup (ns);"
+    <<"false positive rate;"<<std::endl;
+
+  unsigned int n0=1000,dn=1000;
+  double       fdn=1.5;
+  for(unsigned int n=n0;n<=data.size();n+=dn,dn=(unsigned int)(dn*fdn)){
+    auto first=data.begin(),last=data.begin()+n;
+
+    auto build=measure([&]{
+      auto s=make(first,last);
+      return s.size();
+    });
+
+    auto bytes0=allocated_bytes;
+    auto s=make(first,last);
+    auto bytes=allocated_bytes-bytes0;
+
+    auto sfirst=success.begin(),slast=success.begin()+n;
+    auto ffirst=failure.begin(),flast=failure.begin()+n;
+    std::cout
+      <<n<<";"
+      <<build*1E9/n<<";"
+      <<(double)bytes*8/n<<";"
+      <<measure([&]{return contains_all{}(sfirst,slast,s);})*1E9/n<<";"
+      <<measure([&]{return contains_all{}(ffirst,flast,s);})*1E9/n<<";"
+      <<(double)contains_all{}(ffirst,flast,s)/n<<";"
+      <<std::endl;
+  }
+}
+
+template<typename T,typename Hash>
+struct keyed_set:hd::perfect_set<T,Hash,std::equal_to<T>,counting_allocator<T>>
+{
+  using super=hd::perfect_set<T,Hash,std::equal_to<T>,counting_allocator<T>>;
+  using super::super;
+  std::size_t size()const{return this->end()-this->begin();}
+  bool contains(const T& x)const{return this->find(x)!=this->end();}
+};
+
+template<typename T,typename Hash,std::size_t FingerprintBits>
+using filter=hd::perfect_filter<
+  T,Hash,std::equal_to<T>,counting_allocator<T>,FingerprintBits>;
+
+template<typename T,typename Hash,typename Data,typename Input>
+void test_all(const Data& data,const Input& success,const Input& failure)
+{
+  test(
+    "hd::perfect_set",data,success,failure,
+    [](auto first,auto last){return keyed_set<T,Hash>(first,last);});
+  test(
+    "hd::perfect_filter, 8 bits",data,success,failure,
+    [](auto first,auto last){return filter<T,Hash,8>(first,last);});
+  test(
+    "hd::perfect_filter, 16 bits",data,success,failure,
+    [](auto first,auto last){return filter<T,Hash,16>(first,last);});
+}
+
+static std::string make_string(std::size_t x)
+{
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"pfx_%zu_sfx",x);
+  return buffer;
+}
+
+int main()
+{
+  static constexpr std::size_t N=1'000'000;
+  {
+    using value_type=std::size_t;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    for(std::size_t i=0;i<N;++i)data.push_back(dist(gen));
+
+    auto success=data;
+    std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+    auto failure=success;
+    for(auto& x:failure)x+=1;
+
+    std::cout<<"integers"<<std::endl;
+    test_all<value_type,hd::mbs_hash>(data,success,failure);
+  }
+  {
+    using value_type=std::string;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    for(std::size_t i=0;i<N;++i)data.push_back(make_string(dist(gen)));
+
+    auto success=data;
+    std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+    auto failure=success;
+    for(auto& x:failure)x[x.size()/2]='*';
+
+    std::cout<<"strings"<<std::endl;
+    test_all<value_type,hd::mulxp3_string_hash>(data,success,failure);
+  }
+}
@@ -15,17 +15,24 @@
 #include <boost/container_hash/hash.hpp>
 #include <boost/core/bit.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 #include <boost/unordered/detail/foa/core.hpp> /* BOOST_UNORDERED_ASSUME */
 #include <boost/unordered/detail/mulx.hpp>
 #include <boost/unordered/detail/xmx.hpp>
 #include <climits>
+#include <cstdint>
+#include <memory>
 #include <numeric>
 #include <utility>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
+#include "build_statistics.hpp"
+#include "coro_lookup.hpp"
+#include "lookup_instrumentation.hpp"
 #include "mulxp_hash.hpp"
+#include "size_policies.hpp"
 
 namespace fks{
 
@@ -47,89 +54,239 @@ struct duplicate_hash:std::runtime_error
     std::runtime_error("duplicate hash values found"){}
 };
 
-struct pow2_lower_size_policy
+/* size policies are shared with hd::perfect_set */
+
+using hd::pow2_lower_size_policy;
+using hd::pow2_upper_size_policy;
+using hd::fastrange_lower_size_policy;
+using hd::fastrange_upper_size_policy;
+using hd::fastmod_lower_size_policy;
+using hd::fastmod_upper_size_policy;
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>,
+  typename JumpSizePolicy=pow2_upper_size_policy,
+  typename Instrumentation=hd::no_instrumentation,
+  typename ScratchAllocator=std::allocator<T>
+>
+class perfect_set
 {
-  static constexpr inline std::size_t size_index(std::size_t n)
+  template<typename U>
+  using rebind_alloc=
+    typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  template<typename U>
+  using scratch_alloc=
+    typename std::allocator_traits<ScratchAllocator>::
+      template rebind_alloc<U>;
+  using element_array=std::vector<T,Allocator>;
+  using jump_size_policy=JumpSizePolicy;
+  using jump_size_index_type=typename jump_size_policy::size_index_type;
+
+public:
+  static constexpr std::size_t default_lambda=4;
+  using key_type=T;
+  using value_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+  using scratch_allocator_type=ScratchAllocator;
+  using instrumentation_type=Instrumentation;
+  using iterator=typename element_array::const_iterator;
+
+  /* al is used for the lookup tables. Construction scratch memory (and
+   * that of stats()) comes from a default-constructed
+   * scratch_allocator_type, rebound (see hd::perfect_set).
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    positions(al),jumps(al),elements(al)
   {
-    auto exp=n<=2?1:((std::size_t)(boost::core::bit_width(n-1)));
-    return (std::size_t(1)<<exp)-1;
+    build(first,last,lambda,nullptr);
   }
 
-  static constexpr  inline std::size_t size(std::size_t size_index_)
+  /* Same as above, appending to stats a record of every construction
+   * attempt (see hd::build_statistics). Trials are counted in jumps
+   * (shift,width) tried.
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,hd::build_statistics& stats,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    positions(al),jumps(al),elements(al)
   {
-     return size_index_+1;
+    build(first,last,lambda,&stats);
   }
-    
-  static constexpr std::size_t min_size(){return 2;}
 
-  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  perfect_set(const perfect_set& x,const allocator_type& al):
+    h(x.h),pred(x.pred),size_(x.size_),jsize_index(x.jsize_index),
+    positions(x.positions,rebind_alloc<std::size_t>(al)),
+    jumps(x.jumps,rebind_alloc<jump_info>(al)),elements(x.elements,al),
+    lambda_(x.lambda_)
+  {}
+
+  allocator_type get_allocator()const{return elements.get_allocator();}
+  hasher         hash_function()const{return h;}
+
+  iterator begin()const{return elements.begin();}
+  iterator end()const{return elements.begin()+size_;}
+
+  /* Build quality report (see hd::build_quality), with (shift,width) as
+   * displacement parameters. Bucket sizes are recovered by rehashing all
+   * the elements, so this takes about as long as size() lookups.
+   */
+
+  hd::build_quality stats()const
   {
-    return hash&size_index_;
+    hd::build_quality res;
+    res.lambda=lambda_;
+    res.num_elements=size_;
+    res.num_buckets=jumps.size();
+    res.parameter_names[0]="shift";
+    res.parameter_names[1]="width";
+
+    std::vector<std::size_t,scratch_alloc<std::size_t>> bucket_sizes(
+      jumps.size(),0);
+    for(std::size_t i=0;i<size_;++i){
+      ++bucket_sizes[jump_position(h(elements[i]))];
+    }
+    for(std::size_t b=0;b<jumps.size();++b){
+      auto n=bucket_sizes[b];
+      auto width=static_cast<std::size_t>(
+        boost::core::popcount(jumps[b].ws>>8));
+      res.add_bucket(n,static_cast<unsigned char>(jumps[b].ws),width);
+      if(n>=2){
+        res.window_slots+=std::size_t(1)<<width;
+        res.window_gaps+=(std::size_t(1)<<width)-n;
+      }
+    }
+
+    res.space.push_back({
+      "positions",positions.capacity()*sizeof(std::size_t)*CHAR_BIT});
+    res.space.push_back({
+      "jumps",jumps.capacity()*sizeof(jump_info)*CHAR_BIT});
+    res.space.push_back({"elements",elements.capacity()*sizeof(T)*CHAR_BIT});
+    return res;
   }
-};
 
-struct pow2_upper_size_policy
-{
-  static constexpr inline std::size_t size_index(std::size_t n)
+  /* lookup counters and latency samples (see hd::lookup_instrumentation).
+   * As every lookup compares keys, there are no rejected lookups.
+   */
+
+  const instrumentation_type& instrumentation()const{return instr;}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
   {
-    return sizeof(std::size_t)*CHAR_BIT-
-      (n<=2?1:((std::size_t)(boost::core::bit_width(n-1))));
+    auto t=instr.start();
+    return find_hashed(t,x,h(x));
   }
 
-  static constexpr inline std::size_t size(std::size_t size_index_)
+  /* hash must be hash_function()(x) */
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
   {
-     return std::size_t(1)<<(sizeof(std::size_t)*CHAR_BIT-size_index_);  
+    return find_hashed(instr.start(),x,hash);
   }
-    
-  static constexpr std::size_t min_size(){return 2;}
 
-  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  /* Looks up [first,last) in groups of batch_size, prefetching all the
+   * position and jump entries of a group, then all its elements, before
+   * comparing. Results are written to res as with find.
+   */
+
+  static constexpr std::size_t batch_size=16;
+
+  template<typename FwdIterator,typename OutputIterator>
+  OutputIterator find_many(
+    FwdIterator first,FwdIterator last,OutputIterator res)const
   {
-    return hash>>size_index_;
+    return find_many_hashed(
+      first,last,
+      boost::make_transform_iterator(
+        first,[this](const auto& x){return h(x);}),
+      res);
   }
-};
 
-template<
-  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>
->
-class perfect_set
-{
-  using element_array=std::vector<T>;
-  using jump_size_policy=pow2_upper_size_policy;
+  /* hfirst points to the hashes of the elements of [first,last) */
 
-public:
-  static constexpr std::size_t default_lambda=4;
-  using key_type=T;
-  using value_type=T;
-  using hasher=Hash;
-  using key_equal=Pred;
-  using iterator=typename element_array::const_iterator;
-
-  template<typename FwdIterator>
-  perfect_set(
-    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda)
+  template<
+    typename FwdIterator,typename HashInputIterator,typename OutputIterator
+  >
+  OutputIterator find_many_hashed(
+    FwdIterator first,FwdIterator last,HashInputIterator hfirst,
+    OutputIterator res)const
   {
-    while(lambda){
-      if(construct(first,last,lambda))return;
-      lambda/=2;
+    std::size_t hashes[batch_size],epositions[batch_size];
+    while(first!=last){
+      auto        it=first;
+      std::size_t n=0;
+      for(;n<batch_size&&first!=last;++n,++first,++hfirst){
+        hashes[n]=*hfirst;
+        auto jpos=jump_position(hashes[n]);
+        hd::prefetch(&positions[jpos]);
+        hd::prefetch(&jumps[jpos]);
+      }
+      for(std::size_t i=0;i<n;++i){
+        auto jpos=jump_position(hashes[i]);
+        epositions[i]=element_position(hashes[i],positions[jpos],jumps[jpos]);
+        hd::prefetch(&elements[epositions[i]]);
+      }
+      for(std::size_t i=0;i<n;++i,++it){
+        *res++=elements.begin()+complete_lookup(*it,epositions[i]);
+      }
     }
-    throw construction_failure{};
+    return res;
   }
 
-  iterator begin()const{return elements.begin();}
-  iterator end()const{return elements.begin()+size_;}
+  /* Same as find, suspending after prefetching the position and jump
+   * entries and then the element (see hd::lookup_task and
+   * hd::lookup_scheduler).
+   */
 
   template<typename Key>
-  BOOST_FORCEINLINE iterator find(const Key& x)const
+  hd::lookup_task<iterator> co_find(const Key& x)const
   {
     auto hash=h(x);
     auto jpos=jump_position(hash);
+    hd::prefetch(&positions[jpos]);
+    hd::prefetch(&jumps[jpos]);
+    co_await std::suspend_always{};
     auto pos=element_position(hash,positions[jpos],jumps[jpos]);
-    if(!pred(x,elements[pos]))pos=size_;
-    return elements.begin()+pos;
+    hd::prefetch(&elements[pos]);
+    co_await std::suspend_always{};
+    co_return elements.begin()+complete_lookup(x,pos);
   }
 
 private:
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(
+    typename instrumentation_type::token t,const Key& x,std::size_t hash)const
+  {
+    auto jpos=jump_position(hash);
+    auto pos=element_position(hash,positions[jpos],jumps[jpos]);
+    auto found=pred(x,elements[pos]);
+    instr.finish(
+      t,found?hd::lookup_outcome::hit:hd::lookup_outcome::miss);
+    return elements.begin()+(found?pos:size_);
+  }
+
+  /* returns pos if x is found there, size_ otherwise */
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t complete_lookup(
+    const Key& x,std::size_t pos)const
+  {
+    auto found=pred(x,elements[pos]);
+    instr.count(found?hd::lookup_outcome::hit:hd::lookup_outcome::miss);
+    return found?pos:size_;
+  }
+
   struct jump_info
   {
     void set(std::size_t shift,std::size_t width)
@@ -154,10 +311,32 @@ private:
   };
 
   template<typename FwdIterator>
-  bool construct(FwdIterator first,FwdIterator last,std::size_t lambda)
+  void build(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    hd::build_statistics* stats)
+  {
+    while(lambda){
+      if(construct(first,last,lambda,stats)){
+        lambda_=lambda;
+        return;
+      }
+      lambda/=2;
+    }
+    throw construction_failure{};
+  }
+
+  template<typename FwdIterator>
+  bool construct(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    hd::build_statistics* stats)
   {
-    using bucket_node_array=std::vector<bucket_node<FwdIterator>>;
-    using bucket_array=std::vector<bucket_entry<FwdIterator>>;
+    using bucket_node_array=std::vector<
+      bucket_node<FwdIterator>,scratch_alloc<bucket_node<FwdIterator>>>;
+    using bucket_array=std::vector<
+      bucket_entry<FwdIterator>,scratch_alloc<bucket_entry<FwdIterator>>>;
+    using index_array=std::vector<std::size_t,scratch_alloc<std::size_t>>;
+    using bitset=boost::dynamic_bitset<
+      unsigned long,scratch_alloc<unsigned long>>;
 
     size_=static_cast<std::size_t>(std::distance(first,last));
     jsize_index=jump_size_policy::size_index(size_/lambda);
@@ -169,26 +348,36 @@ private:
     elements.resize(size_);
     elements.shrink_to_fit();
 
+    hd::build_recorder rec(stats,lambda,size_,jumps.size());
+    rec.phase(hd::build_phase::hashing);
     bucket_node_array bucket_nodes;
-    bucket_array      buckets(jumps.size());
     bucket_nodes.reserve(size_);
-    for(auto it=first;it!=last;++it){
-      auto   hash=h(*it);
-      auto  &root=buckets[jump_position(hash)];
+    for(auto it=first;it!=last;++it)bucket_nodes.push_back({it,h(*it)});
+
+    rec.phase(hd::build_phase::bucketing);
+    bucket_array buckets(jumps.size());
+    for(auto& node:bucket_nodes){
+      auto  &root=buckets[jump_position(node.hash)];
       auto **ppnode=&root.begin;
       while(*ppnode){
-        if((*ppnode)->hash==hash){
-          if(pred(*((*ppnode)->it),*(it)))throw duplicate_element{};
-          else                            throw duplicate_hash{};
+        if((*ppnode)->hash==node.hash){
+          if(pred(*((*ppnode)->it),*(node.it))){
+            rec.fail(hd::build_failure_reason::duplicate_element);
+            throw duplicate_element{};
+          }
+          else{
+            rec.fail(hd::build_failure_reason::duplicate_hash);
+            throw duplicate_hash{};
+          }
         }
         ppnode=&(*ppnode)->next;
       }
-      bucket_nodes.push_back({it,hash});
-      *ppnode=&bucket_nodes.back();
+      *ppnode=&node;
       ++root.size;
     }
 
-    std::vector<std::size_t> sorted_bucket_indices(buckets.size());
+    rec.phase(hd::build_phase::sorting);
+    index_array sorted_bucket_indices(buckets.size());
     std::iota(sorted_bucket_indices.begin(),sorted_bucket_indices.end(),0u);
     std::sort(
       sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
@@ -196,19 +385,28 @@ private:
         return buckets[i1].size>buckets[i2].size;
       });
 
-    boost::dynamic_bitset<>  mask;
+    /* all buckets go through the same search, reported as placement */
+
+    rec.phase(hd::build_phase::placement);
+    bitset      mask;
     mask.resize(size_,true); /* true --> available */
-    std::vector<std::size_t> offsets;
+    index_array offsets;
+    std::size_t num_inserted=0;
 
     for(std::size_t i=0;i<buckets.size();++i){
       const auto& bucket=buckets[sorted_bucket_indices[i]];
       if(!bucket.size)break; /* remaining buckets also empty*/
 
+      rec.progress(i,num_inserted);
+      num_inserted+=bucket.size;
+
       std::size_t min_wd=
         boost::core::popcount(boost::core::bit_ceil(bucket.size)-1);
 
+      std::uint64_t bucket_trials=0;
       for(unsigned char sh=0;sh<64-min_wd;++sh){
         for(unsigned char wd=min_wd;wd<56;++wd){
+          ++bucket_trials;
           jump_info jmp;
           jmp.set(sh,wd);
 
@@ -236,6 +434,7 @@ private:
               }
               positions[sorted_bucket_indices[i]]=pos;
               jumps[sorted_bucket_indices[i]]=jmp;
+              rec.trials(bucket.size,bucket_trials);
               goto next_jmp;
             }
           next_pos:;
@@ -244,10 +443,14 @@ private:
         next_wd:;
         }
       }
+      rec.fail(
+        hd::build_failure_reason::bucket_unplaceable,
+        bucket.size,bucket_trials);
       return false;
     next_jmp:;
     }
 
+    rec.succeed();
     return true;
   }
 
@@ -267,13 +470,19 @@ private:
     return pos+element_offset(hash,jmp);
   }
 
-  hasher                   h;
-  key_equal                pred;
-  std::size_t              size_;
-  std::size_t              jsize_index;
-  std::vector<std::size_t> positions;
-  std::vector<jump_info>   jumps;
-  element_array            elements;
+  using position_array=std::vector<std::size_t,rebind_alloc<std::size_t>>;
+  using jump_array=std::vector<jump_info,rebind_alloc<jump_info>>;
+
+  hasher               h;
+  key_equal            pred;
+  std::size_t          size_;
+  jump_size_index_type jsize_index;
+  position_array       positions;
+  jump_array           jumps;
+  element_array        elements;
+  std::size_t          lambda_;
+  [[no_unique_address]]
+  instrumentation_type instr;
 };
 
 } /* namespace fks */
@@ -53,6 +53,7 @@ void resume_timing()
 #include <string_view>
 #include "hd_perfect_set.hpp"
 #include "hd_constexpr_perfect_set.hpp"
+#include "hd_prefiltered_set.hpp"
 
 static constexpr frozen::string entitiesf[]
 {
@@ -104,6 +105,11 @@ constexpr hd::constexpr_perfect_set<
   std::string_view,entities_size,hd::mulxp3_string_hash
 > ccps(entitiesv);
 
+/* lookups on literals fold to constants */
+
+static_assert(ccps.contains(std::string_view{"amp"}));
+static_assert(!ccps.contains(std::string_view{"a*p"}));
+
 int main()
 {
   hd::constexpr_perfect_set<
@@ -113,6 +119,10 @@ int main()
   hd::perfect_set<
     std::string_view,
     hd::mulxp3_string_hash>  ps(&entitiesv[0],&entitiesv[entities_size]);
+  hd::prefiltered_set<
+    hd::perfect_set<
+      std::string_view,
+      hd::mulxp3_string_hash>> pps(&entitiesv[0],&entitiesv[entities_size]);
   boost::unordered_flat_set<
     std::string_view,
     hd::mulxp3_string_hash>  ufsm(&entitiesv[0],&entitiesv[entities_size]);
@@ -132,16 +142,18 @@ int main()
   std::cout<<find_all{}(first,last,ccps)<<"\n";
   std::cout<<find_all{}(first,last,cps)<<"\n";
   std::cout<<find_all{}(first,last,ps)<<"\n";
+  std::cout<<find_all{}(first,last,pps)<<"\n";
   std::cout<<find_all{}(first,last,ufsm)<<"\n";
   std::cout<<find_all{}(first,last,ufs)<<"\n";
 
-  std::cout<<"cfs;ccps;cps;ps;ufsm;ufs;\n";
+  std::cout<<"cfs;ccps;cps;ps;pps;ufsm;ufs;\n";
 
   auto run_measures=[&]{
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(cfs)))*1E9/n<<";";
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(ccps)))*1E9/n<<";";
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(cps)))*1E9/n<<";";
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(ps)))*1E9/n<<";";
+    std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(pps)))*1E9/n<<";";
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(ufsm)))*1E9/n<<";";
     std::cout<<measure(boost::bind(find_all{},first,last,boost::cref(ufs)))*1E9/n<<";";
     std::cout<<std::endl;
@@ -0,0 +1,364 @@
+/* PoC of a cache-line-grouped perfect set with bumping.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_BUCKETED_PERFECT_SET_HPP
+#define HD_BUCKETED_PERFECT_SET_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/core/bit.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "mulxp_hash.hpp"
+
+namespace hd{
+
+/* Elements are stored in cache-line-aligned groups, each holding one seed
+ * byte for each of its buckets_per_group buckets followed by
+ * slots_per_group element slots (by default, as many as fit in a cache
+ * line, with a minimum of 4). A key is mapped to a group and to a bucket
+ * within the group, and the bucket's seed determines the key's slot, so
+ * lookup touches only the group (one cache line for integral keys, plus
+ * the out-of-line key data for strings).
+ *
+ * Buckets that can't be placed within their group are "bumped" (seed
+ * value bumped) and their elements moved to a small overflow
+ * hd::perfect_set, which is consulted only for keys in bumped buckets.
+ * As in hd::nonminimal_perfect_set, empty slots hold a copy of a placed
+ * element, which can never match.
+ */
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>,
+  std::size_t SlotsPerGroup=(std::max)(
+    std::size_t(4),(std::size_t(64)-8)/sizeof(T))
+>
+class bucketed_perfect_set
+{
+  static_assert(SlotsPerGroup>0&&SlotsPerGroup<=64);
+
+  template<typename U>
+  using rebind_alloc=
+    typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  using element_array=std::vector<T,Allocator>;
+  using overflow_set=perfect_set<T,Hash,Pred,Allocator>;
+
+public:
+  static constexpr std::size_t  buckets_per_group=8;
+  static constexpr std::size_t  slots_per_group=SlotsPerGroup;
+  static constexpr double       default_load_factor=0.7;
+  static constexpr std::uint8_t bumped=0xFF;
+  using key_type=T;
+  using value_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+
+  class iterator
+  {
+  public:
+    using iterator_category=std::forward_iterator_tag;
+    using value_type=T;
+    using difference_type=std::ptrdiff_t;
+    using pointer=const T*;
+    using reference=const T&;
+
+    iterator()=default;
+
+    reference operator*()const{return *p;}
+    pointer operator->()const{return p;}
+
+    iterator& operator++()
+    {
+      pos=s->next_position(pos+1);
+      p=s->element(pos);
+      return *this;
+    }
+
+    iterator operator++(int)
+    {
+      auto res=*this;
+      ++*this;
+      return res;
+    }
+
+    friend bool operator==(const iterator& x,const iterator& y)
+    {
+      return x.pos==y.pos;
+    }
+
+    friend bool operator!=(const iterator& x,const iterator& y)
+    {
+      return x.pos!=y.pos;
+    }
+
+  private:
+    friend class bucketed_perfect_set;
+
+    iterator(const bucketed_perfect_set* s_,std::size_t pos_,const T* p_):
+      s{s_},pos{pos_},p{p_}{}
+
+    /* positions past the group slots refer to the overflow elements */
+
+    const bucketed_perfect_set* s=nullptr;
+    std::size_t                 pos=0;
+    const T*                    p=nullptr;
+  };
+
+  template<typename FwdIterator>
+  bucketed_perfect_set(
+    FwdIterator first,FwdIterator last,
+    double load_factor=default_load_factor,
+    const allocator_type& al=allocator_type()):
+    size_{static_cast<std::size_t>(std::distance(first,last))},
+    num_groups{scaled_size(size_,load_factor)/slots_per_group+1},
+    groups(al),occupancy(al),
+    overflow{
+      static_cast<const T*>(nullptr),static_cast<const T*>(nullptr),
+      overflow_set::default_lambda,al}
+  {
+    element_array overflow_elements(al);
+    construct(first,last,overflow_elements);
+    overflow=overflow_set{
+      overflow_elements.begin(),overflow_elements.end(),
+      overflow_set::default_lambda,al};
+  }
+
+  allocator_type get_allocator()const{return groups.get_allocator();}
+  hasher         hash_function()const{return h;}
+
+  std::size_t size()const{return size_;}
+  std::size_t overflow_size()const{return overflow.end()-overflow.begin();}
+
+  iterator begin()const
+  {
+    auto pos=next_position(0);
+    return {this,pos,element(pos)};
+  }
+
+  iterator end()const{return {this,slots_size()+overflow_size(),nullptr};}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
+  {
+    return find_hashed(x,h(x));
+  }
+
+  /* hash must be hash_function()(x) */
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    auto        gpos=group_position(hash);
+    const auto& g=groups[gpos];
+    auto        seed=g.seeds[bucket_position(hash)];
+    if(BOOST_UNLIKELY(seed==bumped)){
+      auto it=overflow.find_hashed(x,hash);
+      if(it==overflow.end())return end();
+      return {this,slots_size()+(it-overflow.begin()),&*it};
+    }
+    auto spos=slot_position(hash,seed);
+    const auto& e=g.slots[spos];
+    if(pred(x,e))return {this,gpos*slots_per_group+spos,&e};
+    else         return end();
+  }
+
+private:
+  struct alignas(64) group
+  {
+    std::uint8_t seeds[buckets_per_group]={};
+    T            slots[slots_per_group];
+  };
+  template<typename FwdIterator>
+  struct hashed_element
+  {
+    FwdIterator it;
+    std::size_t hash;
+  };
+
+  /* places as many elements as possible, bumped ones go to
+   * overflow_elements
+   */
+
+  template<typename FwdIterator>
+  void construct(
+    FwdIterator first,FwdIterator last,element_array& overflow_elements)
+  {
+    using hashed_element_array=std::vector<
+      hashed_element<FwdIterator>,
+      rebind_alloc<hashed_element<FwdIterator>>>;
+
+    auto al=get_allocator();
+    groups.resize(num_groups);
+    occupancy.resize(num_groups,0);
+
+    hashed_element_array hashed_elements(al);
+    hashed_elements.reserve(size_);
+    for(auto it=first;it!=last;++it)hashed_elements.push_back({it,h(*it)});
+
+    /* group_position is monotonic on the hash value */
+
+    std::sort(
+      hashed_elements.begin(),hashed_elements.end(),
+      [](const auto& x,const auto& y){return x.hash<y.hash;});
+    for(std::size_t i=1;i<hashed_elements.size();++i){
+      if(hashed_elements[i].hash==hashed_elements[i-1].hash){
+        if(pred(*hashed_elements[i].it,*hashed_elements[i-1].it)){
+          throw duplicate_element{};
+        }
+        else throw duplicate_hash{};
+      }
+    }
+
+    const T* filler=nullptr;
+    for(auto gfirst=hashed_elements.begin();gfirst!=hashed_elements.end();){
+      auto gpos=group_position(gfirst->hash);
+      auto glast=gfirst;
+      while(glast!=hashed_elements.end()&&
+            group_position(glast->hash)==gpos)++glast;
+
+      std::stable_sort(
+        gfirst,glast,[this](const auto& x,const auto& y){
+          return bucket_position(x.hash)<bucket_position(y.hash);
+        });
+      std::pair<decltype(gfirst),decltype(gfirst)> buckets[buckets_per_group];
+      for(std::size_t b=0;b<buckets_per_group;++b){
+        buckets[b]={glast,glast};
+      }
+      for(auto it=gfirst;it!=glast;){
+        auto b=bucket_position(it->hash);
+        auto it2=it;
+        while(it2!=glast&&bucket_position(it2->hash)==b)++it2;
+        buckets[b]={it,it2};
+        it=it2;
+      }
+      std::size_t sorted_buckets[buckets_per_group];
+      for(std::size_t b=0;b<buckets_per_group;++b)sorted_buckets[b]=b;
+      std::sort(
+        std::begin(sorted_buckets),std::end(sorted_buckets),
+        [&](std::size_t b1,std::size_t b2){
+          return buckets[b1].second-buckets[b1].first>
+                 buckets[b2].second-buckets[b2].first;
+        });
+
+      auto& g=groups[gpos];
+      auto& occupied=occupancy[gpos];
+      for(auto b:sorted_buckets){
+        auto [bfirst,blast]=buckets[b];
+        if(bfirst==blast)break; /* remaining buckets also empty */
+
+        auto bucket_size=static_cast<int>(blast-bfirst);
+        auto free_slots=
+          static_cast<int>(slots_per_group)-boost::core::popcount(occupied);
+        std::uint64_t bucket_slots=0;
+        for(std::size_t seed=0;seed<bumped&&bucket_size<=free_slots;++seed){
+          bucket_slots=0;
+          for(auto it=bfirst;it!=blast;++it){
+            auto bit=std::uint64_t(1)<<slot_position(it->hash,seed);
+            if((occupied|bucket_slots)&bit)goto next_seed;
+            bucket_slots|=bit;
+          }
+          g.seeds[b]=static_cast<std::uint8_t>(seed);
+          occupied|=bucket_slots;
+          for(auto it=bfirst;it!=blast;++it){
+            auto& slot=g.slots[slot_position(it->hash,seed)];
+            slot=*(it->it);
+            if(!filler)filler=&slot;
+          }
+          goto next_bucket;
+        next_seed:;
+        }
+        g.seeds[b]=bumped;
+        for(auto it=bfirst;it!=blast;++it){
+          overflow_elements.push_back(*(it->it));
+        }
+      next_bucket:;
+      }
+      gfirst=glast;
+    }
+
+    for(std::size_t gpos=0;gpos<num_groups;++gpos){
+      auto& g=groups[gpos];
+      if(!filler){
+        /* nothing placed, send every lookup to the overflow */
+        for(auto& seed:g.seeds)seed=bumped;
+      }
+      else{
+        for(std::size_t spos=0;spos<slots_per_group;++spos){
+          if(!(occupancy[gpos]&(std::uint64_t(1)<<spos))){
+            g.slots[spos]=*filler;
+          }
+        }
+      }
+    }
+  }
+
+  std::size_t slots_size()const{return num_groups*slots_per_group;}
+
+  const T* element(std::size_t pos)const
+  {
+    if(pos<slots_size()){
+      return &groups[pos/slots_per_group].slots[pos%slots_per_group];
+    }
+    else if(pos<slots_size()+overflow_size()){
+      return &*(overflow.begin()+(pos-slots_size()));
+    }
+    else return nullptr;
+  }
+
+  std::size_t next_position(std::size_t pos)const
+  {
+    while(pos<slots_size()){
+      auto gpos=pos/slots_per_group;
+      auto occupied=occupancy[gpos]>>(pos%slots_per_group);
+      if(occupied)return pos+boost::core::countr_zero(occupied);
+      pos=(gpos+1)*slots_per_group;
+    }
+    return pos;
+  }
+
+  std::size_t group_position(std::size_t hash)const
+  {
+    return mul_high(hash,num_groups);
+  }
+
+  static std::size_t bucket_position(std::size_t hash)
+  {
+    return hash%buckets_per_group;
+  }
+
+  static std::size_t slot_position(std::size_t hash,std::size_t seed)
+  {
+    auto x=static_cast<std::uint32_t>(
+      mulx(hash,0x9e3779b97f4a7c15ull*(2*seed+1)));
+    return static_cast<std::size_t>(
+      (static_cast<std::uint64_t>(x)*slots_per_group)>>32);
+  }
+
+  using group_array=std::vector<group,rebind_alloc<group>>;
+  using occupancy_array=std::vector<std::uint64_t,rebind_alloc<std::uint64_t>>;
+
+  hasher          h;
+  key_equal       pred;
+  std::size_t     size_;
+  std::size_t     num_groups;
+  group_array     groups;
+  occupancy_array occupancy; /* only used for construction and iteration */
+  overflow_set    overflow;
+};
+
+} /* namespace hd */
+
+#endif
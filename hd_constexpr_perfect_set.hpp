@@ -41,6 +41,8 @@ private:
   using element_size_policy=pow2_upper_size_policy;
   static constexpr std::size_t dsize_index=
     displacement_size_policy::size_index(N/lambda);
+  static constexpr std::size_t size_index=
+    element_size_policy::size_index(N);
   using displacement_info=std::pair<std::size_t,std::size_t>;
   using displacement_array=std::array<
     displacement_info,
@@ -66,13 +68,34 @@ public:
     construct(a.begin(),a.end());
   }
 
-  iterator begin()const{return elements.begin();}
-  iterator end()const{return elements.begin()+size_;}
+  constexpr hasher hash_function()const{return h;}
+
+  constexpr iterator begin()const{return elements.begin();}
+  constexpr iterator end()const{return elements.begin()+size_;}
+
+  /* All the table parameters being compile-time constants, lookups reduce
+   * to immediate shifts and masks, and fold to a constant when the key is
+   * also known at compile time.
+   */
+
+  template<typename Key>
+  BOOST_FORCEINLINE constexpr iterator find(const Key& x)const
+  {
+    return find_hashed(x,h(x));
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE constexpr bool contains(const Key& x)const
+  {
+    return find(x)!=end();
+  }
+
+  /* hash must be hash_function()(x) */
 
   template<typename Key>
-  BOOST_FORCEINLINE iterator find(const Key& x)const
+  BOOST_FORCEINLINE constexpr iterator find_hashed(
+    const Key& x,std::size_t hash)const
   {
-    auto hash=h(x);
     auto pos=element_position(hash,displacements[displacement_position(hash)]);
     if(pos>=size_||!pred(x,elements[pos]))pos=size_;
     return elements.begin()+pos;
@@ -104,7 +127,6 @@ private:
      * array whose positions from size_ are taken up. 
      */
 
-    size_index=element_size_policy::size_index(size_);
     auto extended_size=element_size_policy::size(size_index);
 
     bucket_node_array bucket_nodes;
@@ -202,13 +224,13 @@ private:
     return true;
   }
 
-  std::size_t constexpr displacement_position(std::size_t hash)const
+  static constexpr std::size_t displacement_position(std::size_t hash)
   {
     return displacement_size_policy::position(hash,dsize_index);
   }
 
-  std::size_t constexpr element_position(
-    std::size_t hash,const displacement_info& d)const
+  static constexpr std::size_t element_position(
+    std::size_t hash,const displacement_info& d)
   {
     return element_size_policy::position(d.first+d.second*hash,size_index);
   }
@@ -217,7 +239,6 @@ private:
   key_equal                    pred;
   static constexpr std::size_t size_=N;
   displacement_array           displacements={};
-  std::size_t                  size_index;
   element_array                elements={};
 };
 
@@ -0,0 +1,465 @@
+/* External-memory construction of a partitioned keyless HD(C)-based
+ * minimal perfect hash function, stored in a memory-mappable file.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_EXTERNAL_PERFECT_HASH_HPP
+#define HD_EXTERNAL_PERFECT_HASH_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "hd_perfect_hash.hpp"
+#include "mapped_file.hpp"
+#include "packed_array.hpp"
+
+namespace hd{
+
+/* File layout (native-endian 64-bit words):
+ *   - header: magic, number of keys n, number of partitions P,
+ *   - P directory entries: first position of the partition, its number of
+ *     keys, its displacement size index, its code width and the word
+ *     offset of its codes in the file,
+ *   - the displacement codes of every partition, as packed_array words.
+ * Key x belongs to the partition given by the high bits of a bijective
+ * mix of its hash, and is looked up in that partition's sub-table with
+ * the hash itself: position(x) is then the partition's first position
+ * plus the sub-table's position for x.
+ */
+
+namespace external_perfect_hash_detail{
+
+static constexpr std::uint64_t magic=0x3148505458454448ull; /* HDEXTPH1 */
+static constexpr std::size_t   header_words=3;
+static constexpr std::size_t   directory_entry_words=5;
+
+using sub_table=perfect_hash<std::string_view>;
+
+/* the displacement size index of a sub-table is its number of buckets */
+
+static_assert(
+  std::is_same_v<sub_table::displacement_size_index_type,std::size_t>);
+
+inline std::size_t partition(std::size_t hash,std::size_t num_partitions)
+{
+  /* splitmix64 finalizer, so that partitions don't bias sub-table hashes */
+
+  std::uint64_t x=hash;
+  x=(x^(x>>30))*0xbf58476d1ce4e5b9ull;
+  x=(x^(x>>27))*0x94d049bb133111ebull;
+  x^=x>>31;
+  return mul_high(x,num_partitions);
+}
+
+} /* namespace external_perfect_hash_detail */
+
+struct external_build_options
+{
+  /* scratch directory for spill files, sub-tables and the checkpoint
+   * journal, removed on completion
+   */
+
+  std::string work_dir={};
+
+  /* Memory is bounded by that taken to build the sub-table of a partition
+   * (about 40 bytes per key) plus the spill buffers. Partitions take
+   * keys_per_partition keys on average, which requires knowing the total
+   * number of keys: if expected_keys is 0, input files are read once more
+   * to count them.
+   */
+
+  std::size_t keys_per_partition=std::size_t(1)<<22;
+  std::size_t expected_keys=0;
+  std::size_t spill_buffer_records=4096; /* per partition */
+  std::size_t lambda=perfect_hash<std::string_view>::default_lambda;
+};
+
+/* Builds an external_perfect_hash for the keys of the input files (one per
+ * line, without the terminating newline) into output_path:
+ *   1. input files are read in order and the hash of each key, along with
+ *      its file and byte offset, is appended to the spill file of its
+ *      partition,
+ *   2. each partition is loaded, checked for duplicates (keys with equal
+ *      hashes are read back from the inputs to tell duplicate_element
+ *      from duplicate_hash) and its sub-table built and saved,
+ *   3. sub-tables are concatenated into output_path, written under a
+ *      temporary name and then renamed.
+ * Progress is recorded in an append-only journal in work_dir after every
+ * input file and every partition, so that rerunning with the same
+ * arguments after an interruption resumes from there (spill files are
+ * truncated back to their journaled sizes). Journal writes are flushed but
+ * not fsync'ed. Input files must be smaller than 2^48 bytes, and there may
+ * be at most 2^16 of them.
+ */
+
+template<typename Hash=boost::hash<std::string_view>>
+class external_perfect_hash_builder
+{
+public:
+  external_perfect_hash_builder(
+    std::vector<std::string> input_paths_,std::string output_path_,
+    external_build_options opts_):
+    input_paths{std::move(input_paths_)},
+    output_path{std::move(output_path_)},opts{std::move(opts_)}
+  {
+    if(input_paths.size()>max_inputs){
+      throw std::invalid_argument("too many input files");
+    }
+    if(opts.work_dir.empty())opts.work_dir=output_path+".work";
+  }
+
+  void run()
+  {
+    std::filesystem::create_directories(opts.work_dir);
+    read_journal();
+    if(!num_partitions)start();
+    spill();
+    build_partitions();
+    assemble();
+    std::filesystem::remove_all(opts.work_dir);
+  }
+
+private:
+  using sub_table=external_perfect_hash_detail::sub_table;
+
+  static constexpr std::size_t   max_inputs=std::size_t(1)<<16;
+  static constexpr std::uint64_t offset_mask=(std::uint64_t(1)<<48)-1;
+
+  struct record
+  {
+    std::uint64_t hash;
+    std::uint64_t location; /* input index<<48 | byte offset */
+  };
+
+  struct partition_info
+  {
+    bool          built=false;
+    std::uint64_t size=0,dsize_index=0,width=0,num_words=0;
+  };
+
+  std::string path(const std::string& name,std::size_t i)const
+  {
+    return opts.work_dir+"/"+name+"-"+std::to_string(i);
+  }
+
+  std::string journal_path()const{return opts.work_dir+"/journal";}
+
+  void append_journal(const std::string& line)
+  {
+    std::ofstream os(journal_path(),std::ios::app);
+    os<<line<<"\n";
+    os.flush();
+    if(!os)throw std::runtime_error("can't write "+journal_path());
+  }
+
+  /* The journal has a config line followed by "spilled" lines (inputs
+   * done and spill file sizes) and "partition" lines. A trailing partial
+   * line from an interruption is ignored.
+   */
+
+  void read_journal()
+  {
+    std::ifstream is(journal_path());
+    std::string   line;
+    while(std::getline(is,line)){
+      if(is.eof())break; /* no newline: partial line */
+
+      std::istringstream ls(line);
+      std::string        kind;
+      ls>>kind;
+      if(kind=="config"){
+        std::size_t ni,kpp,l;
+        ls>>ni>>num_partitions>>kpp>>l;
+        if(ni!=input_paths.size()||kpp!=opts.keys_per_partition||
+           l!=opts.lambda){
+          throw std::runtime_error(
+            "journal in "+opts.work_dir+" is from a different build");
+        }
+        partitions.assign(num_partitions,{});
+        spill_sizes.assign(num_partitions,0);
+      }
+      else if(kind=="spilled"){
+        ls>>inputs_spilled;
+        for(auto& s:spill_sizes)ls>>s;
+      }
+      else if(kind=="partition"){
+        std::size_t p;
+        ls>>p;
+        auto& pi=partitions.at(p);
+        ls>>pi.size>>pi.dsize_index>>pi.width>>pi.num_words;
+        pi.built=true;
+      }
+      if(!ls)throw std::runtime_error("corrupt journal "+journal_path());
+    }
+  }
+
+  void start()
+  {
+    std::uint64_t n=opts.expected_keys;
+    if(!n){
+      for(const auto& p:input_paths){
+        std::ifstream is(p,std::ios::binary);
+        std::string   line;
+        while(std::getline(is,line))++n;
+      }
+    }
+    num_partitions=(std::max)(
+      std::size_t(1),
+      static_cast<std::size_t>(
+        (n+opts.keys_per_partition-1)/opts.keys_per_partition));
+    partitions.assign(num_partitions,{});
+    spill_sizes.assign(num_partitions,0);
+    append_journal(
+      "config "+std::to_string(input_paths.size())+" "+
+      std::to_string(num_partitions)+" "+
+      std::to_string(opts.keys_per_partition)+" "+
+      std::to_string(opts.lambda));
+  }
+
+  void spill()
+  {
+    if(inputs_spilled==input_paths.size())return;
+
+    /* back to the state after the last input journaled */
+
+    for(std::size_t p=0;p<num_partitions;++p){
+      std::ofstream(path("spill",p),std::ios::binary|std::ios::app);
+      std::filesystem::resize_file(path("spill",p),spill_sizes[p]);
+    }
+
+    std::vector<std::vector<record>> buffers(num_partitions);
+    auto flush=[&](std::size_t p){
+      auto& buf=buffers[p];
+      if(buf.empty())return;
+      std::ofstream os(path("spill",p),std::ios::binary|std::ios::app);
+      os.write(
+        reinterpret_cast<const char*>(buf.data()),
+        static_cast<std::streamsize>(buf.size()*sizeof(record)));
+      if(!os)throw std::runtime_error("can't write "+path("spill",p));
+      spill_sizes[p]+=buf.size()*sizeof(record);
+      buf.clear();
+    };
+
+    for(auto i=inputs_spilled;i<input_paths.size();++i){
+      std::ifstream is(input_paths[i],std::ios::binary);
+      if(!is)throw std::runtime_error("can't open "+input_paths[i]);
+      std::string   line;
+      std::uint64_t offset=0;
+      while(std::getline(is,line)){
+        auto hash=h(std::string_view(line));
+        auto p=external_perfect_hash_detail::partition(hash,num_partitions);
+        buffers[p].push_back({hash,(std::uint64_t(i)<<48)|offset});
+        if(buffers[p].size()>=opts.spill_buffer_records)flush(p);
+        offset+=line.size()+1;
+      }
+      for(std::size_t p=0;p<num_partitions;++p)flush(p);
+
+      std::string entry="spilled "+std::to_string(i+1);
+      for(auto s:spill_sizes)entry+=" "+std::to_string(s);
+      append_journal(entry);
+      inputs_spilled=i+1;
+    }
+  }
+
+  std::string read_key(std::uint64_t location)const
+  {
+    std::ifstream is(input_paths[location>>48],std::ios::binary);
+    is.seekg(static_cast<std::streamoff>(location&offset_mask));
+    std::string key;
+    std::getline(is,key);
+    return key;
+  }
+
+  void build_partitions()
+  {
+    std::vector<record>        records;
+    std::vector<std::uint64_t> hashes;
+    for(std::size_t p=0;p<num_partitions;++p){
+      auto& pi=partitions[p];
+      if(pi.built)continue;
+
+      records.resize(spill_sizes[p]/sizeof(record));
+      std::ifstream is(path("spill",p),std::ios::binary);
+      is.read(
+        reinterpret_cast<char*>(records.data()),
+        static_cast<std::streamsize>(spill_sizes[p]));
+      if(!is)throw std::runtime_error("can't read "+path("spill",p));
+
+      std::sort(
+        records.begin(),records.end(),
+        [](const record& x,const record& y){return x.hash<y.hash;});
+      hashes.clear();
+      for(std::size_t i=0;i<records.size();++i){
+        if(i&&records[i].hash==records[i-1].hash){
+          if(read_key(records[i].location)==
+             read_key(records[i-1].location))throw duplicate_element{};
+          else                                throw duplicate_hash{};
+        }
+        hashes.push_back(records[i].hash);
+      }
+
+      sub_table st(hash_values,hashes.begin(),hashes.end(),opts.lambda);
+      const auto& codes=st.displacement_codes();
+      std::ofstream os(path("part",p),std::ios::binary|std::ios::trunc);
+      os.write(
+        reinterpret_cast<const char*>(codes.data()),
+        static_cast<std::streamsize>(codes.num_words()*8));
+      os.close();
+      if(!os)throw std::runtime_error("can't write "+path("part",p));
+
+      pi={
+        true,st.size(),st.displacement_size_index(),codes.value_width(),
+        codes.num_words()};
+      append_journal(
+        "partition "+std::to_string(p)+" "+std::to_string(pi.size)+" "+
+        std::to_string(pi.dsize_index)+" "+std::to_string(pi.width)+" "+
+        std::to_string(pi.num_words));
+      std::filesystem::remove(path("spill",p));
+    }
+  }
+
+  void assemble()
+  {
+    namespace detail=external_perfect_hash_detail;
+
+    std::vector<std::uint64_t> header;
+    std::uint64_t              n=0,
+                               offset=detail::header_words+
+                                 num_partitions*detail::directory_entry_words;
+    for(const auto& pi:partitions)n+=pi.size;
+    header.push_back(detail::magic);
+    header.push_back(n);
+    header.push_back(num_partitions);
+    std::uint64_t first=0;
+    for(const auto& pi:partitions){
+      header.insert(
+        header.end(),{first,pi.size,pi.dsize_index,pi.width,offset});
+      first+=pi.size;
+      offset+=pi.num_words;
+    }
+
+    auto          tmp_path=output_path+".tmp";
+    std::ofstream os(tmp_path,std::ios::binary|std::ios::trunc);
+    os.write(
+      reinterpret_cast<const char*>(header.data()),
+      static_cast<std::streamsize>(header.size()*8));
+    for(std::size_t p=0;p<num_partitions;++p){
+      std::ifstream is(path("part",p),std::ios::binary);
+      os<<is.rdbuf();
+    }
+    os.close();
+    if(!os)throw std::runtime_error("can't write "+tmp_path);
+    std::filesystem::rename(tmp_path,output_path);
+  }
+
+  std::vector<std::string>    input_paths;
+  std::string                 output_path;
+  external_build_options      opts;
+  Hash                        h;
+  std::size_t                 num_partitions=0;
+  std::size_t                 inputs_spilled=0;
+  std::vector<std::uint64_t>  spill_sizes;
+  std::vector<partition_info> partitions;
+};
+
+/* Read-only minimal perfect hash function over a file written by
+ * external_perfect_hash_builder, memory-mapped where supported (Linux)
+ * and read into memory otherwise. Hash must be that used for
+ * construction. Files whose header or directory refer to data past their
+ * end are rejected on opening.
+ */
+
+template<typename Hash=boost::hash<std::string_view>>
+class external_perfect_hash
+{
+public:
+  using hasher=Hash;
+
+  explicit external_perfect_hash(const std::string& path):file{path}
+  {
+    namespace detail=external_perfect_hash_detail;
+
+    words=reinterpret_cast<const std::uint64_t*>(file.data());
+    num_words=file.size()/8;
+    if(num_words<detail::header_words||words[0]!=detail::magic||
+       words[2]==0||
+       words[2]>(num_words-detail::header_words)/
+         detail::directory_entry_words){
+      throw std::runtime_error(path+" is not a perfect hash file");
+    }
+    size_=words[1];
+    num_partitions=words[2];
+    directory=words+detail::header_words;
+    for(std::size_t i=0;i<num_partitions;++i){
+      if(!valid_entry(directory+i*detail::directory_entry_words)){
+        throw std::runtime_error(path+" is not a perfect hash file");
+      }
+    }
+  }
+
+  hasher hash_function()const{return h;}
+
+  std::size_t size()const{return size_;}
+
+  /* whole file, in bits */
+
+  std::size_t size_in_bits()const{return num_words*64;}
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t operator()(const Key& x)const
+  {
+    return position(h(x));
+  }
+
+  BOOST_FORCEINLINE std::size_t position(std::size_t hash)const
+  {
+    namespace detail=external_perfect_hash_detail;
+
+    auto e=directory+
+      detail::partition(hash,num_partitions)*detail::directory_entry_words;
+    if(BOOST_UNLIKELY(!e[1]))return 0;
+    return static_cast<std::size_t>(e[0])+detail::sub_table::position(
+      hash,e[1],e[2],
+      packed_array_view{words+e[4],static_cast<std::size_t>(e[2]),e[3]});
+  }
+
+private:
+  /* the codes of a non-empty partition lie within the file (word count
+   * as in packed_array_view::num_words, computed without overflow)
+   */
+
+  bool valid_entry(const std::uint64_t* e)const
+  {
+    if(!e[1])return true;
+    if(e[3]>64||e[4]>num_words)return false;
+    auto width=e[3],
+         full=e[2]/64*width,
+         rest=(e[2]%64*width+63)/64+(width?1:2),
+         available=num_words-e[4];
+    return full<=available&&rest<=available-full;
+  }
+
+  mapped_file          file;
+  hasher               h;
+  std::size_t          size_=0,num_partitions=0,num_words=0;
+  const std::uint64_t* words=nullptr;
+  const std::uint64_t* directory=nullptr;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,375 @@
+/* PoC of a non-minimal HD(C)-based perfect set.
+ * https://cmph.sourceforge.net/papers/esa09.pdf
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_NONMINIMAL_PERFECT_SET_HPP
+#define HD_NONMINIMAL_PERFECT_SET_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "build_statistics.hpp"
+#include "hd_perfect_set.hpp"
+
+namespace hd{
+
+/* Elements are laid out in an array spanning the whole virtual extended
+ * range, the smallest size no less than size/load_factor allowed by
+ * ElementSizePolicy (a power of two by default; see scaled_size for the
+ * load factors accepted), so that every position computed on lookup is
+ * valid and find() reduces to hash/position/compare with no range check.
+ * Empty slots are filled with a copy of some element e: a key equal to e
+ * hashes to e's position, so it can never be matched against a filler.
+ * Buckets are placed much more easily than in the minimal case as free
+ * slots never run out.
+ */
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>,
+  typename DisplacementSizePolicy=pow2_lower_size_policy,
+  typename ElementSizePolicy=pow2_upper_size_policy
+>
+class nonminimal_perfect_set
+{
+  template<typename U>
+  using rebind_alloc=
+    typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  using element_array=std::vector<T,Allocator>;
+  using displacement_size_policy=DisplacementSizePolicy;
+  using element_size_policy=ElementSizePolicy;
+  using displacement_size_index_type=
+    typename displacement_size_policy::size_index_type;
+  using element_size_index_type=
+    typename element_size_policy::size_index_type;
+  using bitset=boost::dynamic_bitset<
+    unsigned long,rebind_alloc<unsigned long>>;
+
+public:
+  static constexpr std::size_t default_lambda=4;
+  static constexpr double      default_load_factor=0.9;
+  using key_type=T;
+  using value_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+
+  class iterator
+  {
+  public:
+    using iterator_category=std::forward_iterator_tag;
+    using value_type=T;
+    using difference_type=std::ptrdiff_t;
+    using pointer=const T*;
+    using reference=const T&;
+
+    iterator()=default;
+
+    reference operator*()const{return s->elements[pos];}
+    pointer operator->()const{return &s->elements[pos];}
+
+    iterator& operator++()
+    {
+      pos=s->next_occupied(pos+1);
+      return *this;
+    }
+
+    iterator operator++(int)
+    {
+      auto res=*this;
+      ++*this;
+      return res;
+    }
+
+    friend bool operator==(const iterator& x,const iterator& y)
+    {
+      return x.pos==y.pos;
+    }
+
+    friend bool operator!=(const iterator& x,const iterator& y)
+    {
+      return x.pos!=y.pos;
+    }
+
+  private:
+    friend class nonminimal_perfect_set;
+
+    iterator(const nonminimal_perfect_set* s_,std::size_t pos_):
+      s{s_},pos{pos_}{}
+
+    const nonminimal_perfect_set* s=nullptr;
+    std::size_t                   pos=0;
+  };
+
+  template<typename FwdIterator>
+  nonminimal_perfect_set(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    double load_factor=default_load_factor,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),occupied(al)
+  {
+    build(first,last,lambda,load_factor,nullptr);
+  }
+
+  /* Same as above, appending to stats a record of every construction
+   * attempt (see build_statistics).
+   */
+
+  template<typename FwdIterator>
+  nonminimal_perfect_set(
+    FwdIterator first,FwdIterator last,build_statistics& stats,
+    std::size_t lambda=default_lambda,
+    double load_factor=default_load_factor,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),occupied(al)
+  {
+    build(first,last,lambda,load_factor,&stats);
+  }
+
+  allocator_type get_allocator()const{return elements.get_allocator();}
+  hasher         hash_function()const{return h;}
+
+  std::size_t size()const{return size_;}
+  std::size_t capacity()const{return elements.size();}
+
+  iterator begin()const{return {this,next_occupied(0)};}
+  iterator end()const{return {this,end_pos};}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
+  {
+    return find_hashed(x,h(x));
+  }
+
+  /* hash must be hash_function()(x) */
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    auto pos=element_position(hash,displacements[displacement_position(hash)]);
+    auto mask=std::size_t(0)-std::size_t(pred(x,elements[pos]));
+    return {this,(pos&mask)|(end_pos&~mask)};
+  }
+
+private:
+  using displacement_info=std::pair<std::size_t,std::size_t>;
+  template<typename FwdIterator>
+  struct bucket_node
+  {
+    FwdIterator  it;
+    std::size_t  hash;
+    bucket_node *next=nullptr;
+  };
+  template<typename FwdIterator>
+  struct bucket_entry
+  {
+    bucket_node<FwdIterator> *begin=nullptr;
+    std::size_t               size=0;
+  };
+
+  template<typename FwdIterator>
+  void build(
+    FwdIterator first,FwdIterator last,
+    std::size_t lambda,double load_factor,build_statistics* stats)
+  {
+    while(lambda){
+      if(construct(first,last,lambda,load_factor,stats))return;
+      lambda/=2;
+    }
+    throw construction_failure{};
+  }
+
+  template<typename FwdIterator>
+  bool construct(
+    FwdIterator first,FwdIterator last,
+    std::size_t lambda,double load_factor,build_statistics* stats)
+  {
+    using bucket_node_array=std::vector<
+      bucket_node<FwdIterator>,rebind_alloc<bucket_node<FwdIterator>>>;
+    using bucket_array=std::vector<
+      bucket_entry<FwdIterator>,rebind_alloc<bucket_entry<FwdIterator>>>;
+    using index_array=std::vector<std::size_t,rebind_alloc<std::size_t>>;
+
+    auto al=get_allocator();
+    size_=static_cast<std::size_t>(std::distance(first,last));
+    size_index=element_size_policy::size_index(
+      scaled_size(size_,load_factor));
+    dsize_index=displacement_size_policy::size_index(size_/lambda);
+    displacements.resize(displacement_size_policy::size(dsize_index));
+    displacements.shrink_to_fit();
+
+    auto extended_size=element_size_policy::size(size_index);
+    elements.clear();
+    elements.resize(extended_size);
+    elements.shrink_to_fit();
+    occupied.clear();
+    occupied.resize(extended_size,false);
+
+    /* with no elements, every lookup lands on the last slot, which is
+     * then made the end position.
+     */
+
+    end_pos=size_?extended_size:extended_size-1;
+
+    build_recorder rec(stats,lambda,size_,displacements.size());
+    rec.phase(build_phase::hashing);
+    bucket_node_array bucket_nodes(al);
+    bucket_nodes.reserve(size_);
+    for(auto it=first;it!=last;++it)bucket_nodes.push_back({it,h(*it)});
+
+    rec.phase(build_phase::bucketing);
+    bucket_array buckets(displacements.size(),al);
+    for(auto& node:bucket_nodes){
+      auto  &root=buckets[displacement_position(node.hash)];
+      auto **ppnode=&root.begin;
+      while(*ppnode){
+        if((*ppnode)->hash==node.hash){
+          if(pred(*((*ppnode)->it),*(node.it))){
+            rec.fail(build_failure_reason::duplicate_element);
+            throw duplicate_element{};
+          }
+          else{
+            rec.fail(build_failure_reason::duplicate_hash);
+            throw duplicate_hash{};
+          }
+        }
+        ppnode=&(*ppnode)->next;
+      }
+      *ppnode=&node;
+      ++root.size;
+    }
+
+    rec.phase(build_phase::sorting);
+    index_array sorted_bucket_indices(buckets.size(),al);
+    std::iota(sorted_bucket_indices.begin(),sorted_bucket_indices.end(),0u);
+    std::sort(
+      sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
+      [&](std::size_t i1,std::size_t i2){
+        return buckets[i1].size>buckets[i2].size;
+      });
+
+    rec.phase(build_phase::placement);
+    index_array bucket_positions(al);
+    std::size_t num_inserted=0;
+    std::size_t i=0;
+    for(;i<buckets.size();++i){
+      const auto& bucket=buckets[sorted_bucket_indices[i]];
+      if(bucket.size<=1)break; /* on to buckets of size 1 */
+
+      rec.progress(i,num_inserted);
+      num_inserted+=bucket.size;
+
+      std::uint64_t bucket_trials=0;
+      for(std::size_t d0=0;d0<extended_size;++d0){
+        for(std::size_t d1=0;d1<extended_size;++d1){
+          ++bucket_trials;
+          displacement_info d={
+            element_size_policy::preimage(d0,size_index),(d1<<32)+1};
+
+          bucket_positions.clear();
+          for(auto pnode=bucket.begin;pnode;pnode=pnode->next){
+            auto pos=element_position(pnode->hash,d);
+            if(occupied[pos]){
+              for(auto pos2:bucket_positions)occupied[pos2]=false;
+              goto next_displacement;
+            }
+            occupied[pos]=true;
+            bucket_positions.push_back(pos);
+          }
+          displacements[sorted_bucket_indices[i]]=d;
+          {
+            auto pnode=bucket.begin;
+            for(auto pos:bucket_positions){
+              elements[pos]=*(pnode->it);
+              pnode=pnode->next;
+            }
+          }
+          rec.trials(bucket.size,bucket_trials);
+          goto next_bucket;
+          next_displacement:;
+        }
+      }
+      rec.fail(
+        build_failure_reason::bucket_unplaceable,bucket.size,bucket_trials);
+      return false;
+    next_bucket:;
+    }
+
+    /* buckets of size <=1 */
+
+    rec.phase(build_phase::singletons);
+    std::size_t pos=0;
+    for(;i<buckets.size();++i){
+      const auto& bucket=buckets[sorted_bucket_indices[i]];
+      if(!bucket.size)break; /* remaining buckets also empty */
+
+      rec.progress(i,num_inserted++);
+      while(occupied[pos])++pos;
+      displacements[sorted_bucket_indices[i]]={
+        element_size_policy::preimage(pos,size_index),0};
+      elements[pos]=*(bucket.begin->it);
+      occupied[pos]=true;
+    }
+
+    for(;i<buckets.size();++i){
+      /* send all empty buckets to the last slot */
+      displacements[sorted_bucket_indices[i]]={~std::size_t(0),0};
+    }
+
+    if(size_){
+      auto filler=elements[occupied.find_first()];
+      for(pos=0;pos<extended_size;++pos){
+        if(!occupied[pos])elements[pos]=filler;
+      }
+    }
+    rec.succeed();
+    return true;
+  }
+
+  std::size_t next_occupied(std::size_t pos)const
+  {
+    if(pos==0)pos=occupied.find_first();
+    else      pos=occupied.find_next(pos-1);
+    return pos<occupied.size()?pos:end_pos;
+  }
+
+  std::size_t displacement_position(std::size_t hash)const
+  {
+    return displacement_size_policy::position(hash,dsize_index);
+  }
+
+  std::size_t element_position(
+    std::size_t hash,const displacement_info& d)const
+  {
+    return element_size_policy::position(d.first+d.second*hash,size_index);
+  }
+
+  using displacement_array=
+    std::vector<displacement_info,rebind_alloc<displacement_info>>;
+
+  hasher                       h;
+  key_equal                    pred;
+  std::size_t                  size_;
+  displacement_size_index_type dsize_index;
+  displacement_array           displacements;
+  element_size_index_type      size_index;
+  std::size_t                  end_pos;
+  element_array                elements;
+  bitset                       occupied; /* only used for iteration */
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,123 @@
+/* PoC of an order-preserving perfect set based on a keyless HD(C)
+ * minimal perfect hash function.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_ORDER_PRESERVING_PERFECT_SET_HPP
+#define HD_ORDER_PRESERVING_PERFECT_SET_HPP
+
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/core/bit.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "hd_perfect_hash.hpp"
+#include "packed_array.hpp"
+
+namespace hd{
+
+/* Elements are stored in construction order, so that find(x)-begin() (or
+ * index_of(x)) is the position of x in the input range and can index
+ * arrays parallel to it. hd::perfect_hash gives each element a slot
+ * holding its rank in bit_width(n-1) bits: lookup reads a displacement
+ * code, then a rank, then the element. As any order-preserving minimal
+ * perfect hash function takes at least log2(n) bits per element, the
+ * ranks are what dominates the size of the index, which stays well below
+ * that of a plain hd::perfect_set plus a permutation array.
+ */
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>
+>
+class order_preserving_perfect_set
+{
+  using perfect_hash_type=perfect_hash<T,Hash,Pred,Allocator>;
+  using rank_array=packed_array<
+    typename std::allocator_traits<Allocator>::
+      template rebind_alloc<std::uint64_t>>;
+  using element_array=std::vector<T,Allocator>;
+
+public:
+  static constexpr std::size_t default_lambda=perfect_hash_type::default_lambda;
+  using key_type=T;
+  using value_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+  using iterator=typename element_array::const_iterator;
+
+  template<typename FwdIterator>
+  order_preserving_perfect_set(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    ph{first,last,lambda,al},
+    ranks(ph.size(),rank_width(ph.size()),al),
+    elements(first,last,al)
+  {
+    for(std::size_t i=0;i<elements.size();++i){
+      ranks.set(ph(elements[i]),i);
+    }
+  }
+
+  allocator_type get_allocator()const{return ph.get_allocator();}
+  hasher         hash_function()const{return ph.hash_function();}
+
+  std::size_t size()const{return elements.size();}
+
+  /* memory used by the index (all but the elements), in bits */
+
+  std::size_t index_size_in_bits()const
+  {
+    return ph.size_in_bits()+ranks.capacity_in_bits();
+  }
+
+  iterator begin()const{return elements.begin();}
+  iterator end()const{return elements.end();}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
+  {
+    return find_hashed(x,ph.hash_function()(x));
+  }
+
+  /* hash must be hash_function()(x) */
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    if(BOOST_UNLIKELY(elements.empty()))return end();
+    auto rank=static_cast<std::size_t>(ranks.get(ph.position(hash)));
+    if(!pred(x,elements[rank]))return end();
+    return elements.begin()+rank;
+  }
+
+  /* position of x in the construction range, size() if not present */
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t index_of(const Key& x)const
+  {
+    return static_cast<std::size_t>(find(x)-begin());
+  }
+
+private:
+  static std::size_t rank_width(std::size_t n)
+  {
+    return n<=1?1:static_cast<std::size_t>(boost::core::bit_width(n-1));
+  }
+
+  perfect_hash_type ph;
+  rank_array        ranks;
+  element_array     elements;
+  key_equal         pred;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,100 @@
+/* PoC of an approximate-membership filter based on a keyless HD(C)
+ * minimal perfect hash function.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_PERFECT_FILTER_HPP
+#define HD_PERFECT_FILTER_HPP
+
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "hd_perfect_hash.hpp"
+#include "mulxp_hash.hpp"
+#include "packed_array.hpp"
+
+namespace hd{
+
+/* Only a FingerprintBits-bit fingerprint of each element is stored, at the
+ * position given by hd::perfect_hash. contains(x) is always true for
+ * the construction elements and true with probability
+ * 2^-FingerprintBits for any other key. Lookup reads the element's
+ * displacement code and then its fingerprint. Fingerprints are taken from
+ * a remix of the hash so as not to correlate with the hash bits already
+ * used for positioning.
+ */
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>,
+  std::size_t FingerprintBits=8
+>
+class perfect_filter
+{
+  static_assert(FingerprintBits>0&&FingerprintBits<=64);
+
+  using perfect_hash_type=perfect_hash<T,Hash,Pred,Allocator>;
+  using fingerprint_array=packed_array<
+    typename std::allocator_traits<Allocator>::
+      template rebind_alloc<std::uint64_t>>;
+
+public:
+  static constexpr std::size_t default_lambda=perfect_hash_type::default_lambda;
+  static constexpr std::size_t fingerprint_bits=FingerprintBits;
+  using key_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+
+  template<typename FwdIterator>
+  perfect_filter(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    ph{first,last,lambda,al},
+    fingerprints(ph.size(),fingerprint_bits,al)
+  {
+    for(auto it=first;it!=last;++it){
+      auto hash=ph.hash_function()(*it);
+      fingerprints.set(ph.position(hash),fingerprint(hash));
+    }
+  }
+
+  allocator_type get_allocator()const{return ph.get_allocator();}
+  hasher         hash_function()const{return ph.hash_function();}
+
+  std::size_t size()const{return ph.size();}
+
+  /* memory used, in bits */
+
+  std::size_t size_in_bits()const
+  {
+    return ph.size_in_bits()+fingerprints.capacity_in_bits();
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE bool contains(const Key& x)const
+  {
+    auto hash=ph.hash_function()(x);
+    return size()&&
+      fingerprints.get(ph.position(hash))==fingerprint(hash);
+  }
+
+private:
+  static std::uint64_t fingerprint(std::size_t hash)
+  {
+    return mulx(hash,0x9e3779b97f4a7c15ull)>>(64-fingerprint_bits);
+  }
+
+  perfect_hash_type ph;
+  fingerprint_array fingerprints;
+};
+
+} /* namespace hd */
+
+#endif
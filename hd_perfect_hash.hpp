@@ -0,0 +1,341 @@
+/* PoC of a keyless HD(C)-based minimal perfect hash function.
+ * https://cmph.sourceforge.net/papers/esa09.pdf
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_PERFECT_HASH_HPP
+#define HD_PERFECT_HASH_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/core/bit.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include "build_statistics.hpp"
+#include "hd_perfect_set.hpp"
+#include "packed_array.hpp"
+
+namespace hd{
+
+/* Tag for constructing a perfect_hash from the hash values of the
+ * elements rather than the elements themselves.
+ */
+
+struct hash_values_t{};
+inline constexpr hash_values_t hash_values{};
+
+/* Maps each of the n construction elements to a distinct position in
+ * [0,n) without storing the elements; any other key is mapped to some
+ * arbitrary position in the same range. Used as the building block of
+ * keyless structures (filters, static functions).
+ *
+ * Each bucket gets a displacement code packed in as few bits as possible:
+ *   - code<n: the bucket is a singleton placed at position code (also used
+ *     for empty buckets),
+ *   - code>=n: the bucket is placed at mul_high(d0+d1*hash,n), with d0, d1
+ *     derived from the trial number t=code-n.
+ * Trials are numbered so that the most likely successful displacements
+ * have the smallest codes, which thus take about log2(n)+1 bits; the
+ * total is around (log2(n)+1)/lambda bits per element.
+ * n must be less than 2^32.
+ */
+
+template<
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>
+>
+class perfect_hash
+{
+  template<typename U>
+  using rebind_alloc=
+    typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  using displacement_size_policy=fastrange_lower_size_policy;
+  using bitset=boost::dynamic_bitset<
+    unsigned long,rebind_alloc<unsigned long>>;
+
+public:
+  using displacement_size_index_type=
+    typename displacement_size_policy::size_index_type;
+  using code_array=packed_array<rebind_alloc<std::uint64_t>>;
+  static constexpr std::size_t default_lambda=5;
+  static constexpr std::size_t max_trials=std::size_t(1)<<24;
+  using key_type=T;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+
+  template<typename FwdIterator>
+  perfect_hash(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al_=allocator_type()):
+    al{al_},codes(al_)
+  {
+    build(first,last,lambda,nullptr);
+  }
+
+  /* Same as above, appending to stats a record of every construction
+   * attempt (see build_statistics).
+   */
+
+  template<typename FwdIterator>
+  perfect_hash(
+    FwdIterator first,FwdIterator last,build_statistics& stats,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al_=allocator_type()):
+    al{al_},codes(al_)
+  {
+    build(first,last,lambda,&stats);
+  }
+
+  /* [first,last) are the hash values of the elements, which must be
+   * distinct: equal values throw duplicate_hash, as the elements can't be
+   * compared.
+   */
+
+  template<typename FwdIterator>
+  perfect_hash(
+    hash_values_t,FwdIterator first,FwdIterator last,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al_=allocator_type()):
+    al{al_},codes(al_)
+  {
+    build<true>(first,last,lambda,nullptr);
+  }
+
+  allocator_type get_allocator()const{return al;}
+  hasher         hash_function()const{return h;}
+
+  std::size_t size()const{return size_;}
+
+  /* memory used by the displacement codes, in bits */
+
+  std::size_t size_in_bits()const{return codes.capacity_in_bits();}
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t operator()(const Key& x)const
+  {
+    return position(h(x));
+  }
+
+  BOOST_FORCEINLINE std::size_t position(std::size_t hash)const
+  {
+    return position(hash,size_,dsize_index,codes);
+  }
+
+  /* Raw layout, for storing the function elsewhere (see
+   * external_perfect_hash): lookup is then done with the static
+   * position(hash,size(),displacement_size_index(),codes) on codes
+   * holding the values of displacement_codes().
+   */
+
+  displacement_size_index_type displacement_size_index()const
+  {
+    return dsize_index;
+  }
+
+  const code_array& displacement_codes()const{return codes;}
+
+  template<typename Codes>
+  static BOOST_FORCEINLINE std::size_t position(
+    std::size_t hash,std::size_t n,
+    const displacement_size_index_type& dsize_index,const Codes& codes)
+  {
+    auto code=codes.get(displacement_size_policy::position(hash,dsize_index));
+    auto t=code-n;
+    return code<n?
+      static_cast<std::size_t>(code):
+      trial_position(hash,static_cast<std::size_t>(t),n);
+  }
+
+private:
+  template<typename FwdIterator>
+  struct hashed_element
+  {
+    FwdIterator it;
+    std::size_t hash;
+  };
+
+  /* HashValues: [first,last) holds hash values rather than elements */
+
+  template<bool HashValues=false,typename FwdIterator>
+  void build(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    build_statistics* stats)
+  {
+    while(lambda){
+      if(construct<HashValues>(first,last,lambda,stats))return;
+      lambda/=2;
+    }
+    throw construction_failure{};
+  }
+
+  template<bool HashValues,typename FwdIterator>
+  bool construct(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    build_statistics* stats)
+  {
+    using hashed_element_array=std::vector<
+      hashed_element<FwdIterator>,
+      rebind_alloc<hashed_element<FwdIterator>>>;
+    using index_array=std::vector<std::size_t,rebind_alloc<std::size_t>>;
+
+    size_=static_cast<std::size_t>(std::distance(first,last));
+    dsize_index=displacement_size_policy::size_index(size_/lambda);
+    auto num_buckets=displacement_size_policy::size(dsize_index);
+
+    build_recorder rec(stats,lambda,size_,num_buckets);
+    rec.phase(build_phase::hashing);
+    hashed_element_array hashed_elements(al);
+    hashed_elements.reserve(size_);
+    for(auto it=first;it!=last;++it){
+      if constexpr(HashValues)hashed_elements.push_back({it,*it});
+      else                    hashed_elements.push_back({it,h(*it)});
+    }
+
+    rec.phase(build_phase::bucketing);
+    std::sort(
+      hashed_elements.begin(),hashed_elements.end(),
+      [this](const auto& x,const auto& y){
+        auto bx=displacement_position(x.hash),by=displacement_position(y.hash);
+        return bx<by||(bx==by&&x.hash<y.hash);
+      });
+    for(std::size_t i=1;i<hashed_elements.size();++i){
+      if(hashed_elements[i].hash==hashed_elements[i-1].hash){
+        if constexpr(HashValues){
+          rec.fail(build_failure_reason::duplicate_hash);
+          throw duplicate_hash{};
+        }
+        else if(pred(*hashed_elements[i].it,*hashed_elements[i-1].it)){
+          rec.fail(build_failure_reason::duplicate_element);
+          throw duplicate_element{};
+        }
+        else{
+          rec.fail(build_failure_reason::duplicate_hash);
+          throw duplicate_hash{};
+        }
+      }
+    }
+
+    /* bucket b spans [bucket_starts[b],bucket_starts[b+1]) */
+
+    index_array bucket_starts(num_buckets+1,0,al);
+    for(const auto& x:hashed_elements){
+      ++bucket_starts[displacement_position(x.hash)+1];
+    }
+    std::partial_sum(
+      bucket_starts.begin(),bucket_starts.end(),bucket_starts.begin());
+    auto bucket_size=[&](std::size_t b){
+      return bucket_starts[b+1]-bucket_starts[b];
+    };
+
+    rec.phase(build_phase::sorting);
+    index_array sorted_bucket_indices(num_buckets,al);
+    std::iota(sorted_bucket_indices.begin(),sorted_bucket_indices.end(),0u);
+    std::stable_sort(
+      sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
+      [&](std::size_t i1,std::size_t i2){
+        return bucket_size(i1)>bucket_size(i2);
+      });
+
+    rec.phase(build_phase::placement);
+    index_array bucket_codes(num_buckets,0,al);
+    index_array bucket_positions(al);
+    bitset      occupied(size_,false,al);
+    std::size_t max_code=0;
+    std::size_t num_inserted=0;
+    std::size_t i=0;
+    for(;i<num_buckets;++i){
+      auto b=sorted_bucket_indices[i];
+      if(bucket_size(b)<=1)break; /* on to buckets of size 1 */
+
+      rec.progress(i,num_inserted);
+      num_inserted+=bucket_size(b);
+
+      for(std::size_t t=0;t<max_trials;++t){
+        bucket_positions.clear();
+        for(auto j=bucket_starts[b];j<bucket_starts[b+1];++j){
+          auto pos=trial_position(hashed_elements[j].hash,t);
+          if(occupied[pos]){
+            for(auto pos2:bucket_positions)occupied[pos2]=false;
+            goto next_trial;
+          }
+          occupied[pos]=true;
+          bucket_positions.push_back(pos);
+        }
+        bucket_codes[b]=size_+t;
+        max_code=(std::max)(max_code,size_+t);
+        rec.trials(bucket_size(b),t+1);
+        goto next_bucket;
+      next_trial:;
+      }
+      rec.fail(
+        build_failure_reason::bucket_unplaceable,bucket_size(b),max_trials);
+      return false;
+    next_bucket:;
+    }
+
+    /* buckets of size 1, empty buckets keep code 0 */
+
+    rec.phase(build_phase::singletons);
+    std::size_t pos=0;
+    for(;i<num_buckets;++i){
+      auto b=sorted_bucket_indices[i];
+      if(!bucket_size(b))break; /* remaining buckets also empty */
+
+      rec.progress(i,num_inserted++);
+      while(occupied[pos])++pos;
+      bucket_codes[b]=pos;
+      max_code=(std::max)(max_code,pos);
+      occupied[pos]=true;
+    }
+
+    codes=code_array(
+      num_buckets,
+      static_cast<std::size_t>(boost::core::bit_width(max_code)),al);
+    for(std::size_t b=0;b<num_buckets;++b)codes.set(b,bucket_codes[b]);
+    rec.succeed();
+    return true;
+  }
+
+  std::size_t displacement_position(std::size_t hash)const
+  {
+    return displacement_size_policy::position(hash,dsize_index);
+  }
+
+  BOOST_FORCEINLINE std::size_t trial_position(
+    std::size_t hash,std::size_t t)const
+  {
+    return trial_position(hash,t,size_);
+  }
+
+  static BOOST_FORCEINLINE std::size_t trial_position(
+    std::size_t hash,std::size_t t,std::size_t n)
+  {
+    /* t==0 yields the identity transformation of hash */
+
+    std::uint64_t d0=t*0x9e3779b97f4a7c15ull,
+                  d1=(t*0xbf58476d1ce4e5b9ull)|1;
+    return mul_high(d0+d1*hash,n);
+  }
+
+  allocator_type               al;
+  hasher                       h;
+  key_equal                    pred;
+  std::size_t                  size_;
+  displacement_size_index_type dsize_index;
+  code_array                   codes;
+};
+
+} /* namespace hd */
+
+#endif
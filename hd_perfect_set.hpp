@@ -11,24 +11,35 @@
 #define HD_PERFECT_SET_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <boost/config.hpp>
 #include <boost/container_hash/hash.hpp>
 #include <boost/core/bit.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 #include <boost/unordered/detail/mulx.hpp>
 #include <boost/unordered/detail/xmx.hpp>
 #include <climits>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <ranges>
 #include <utility>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <type_traits>
 #include <vector>
+#include "build_statistics.hpp"
+#include "coro_lookup.hpp"
+#include "hit_counters.hpp"
+#include "lookup_instrumentation.hpp"
 #include "mulxp_hash.hpp"
-
-#ifdef HD_PERFECT_SET_TRACE
-#include <iostream>
-#endif
+#include "size_policies.hpp"
 
 namespace hd{
 
@@ -50,90 +61,567 @@ struct duplicate_hash:std::runtime_error
     std::runtime_error("duplicate hash values found"){}
 };
 
-struct pow2_lower_size_policy
-{
-  static constexpr inline std::size_t size_index(std::size_t n)
-  {
-    auto exp=n<=2?1:((std::size_t)(boost::core::bit_width(n-1)));
-    return (std::size_t(1)<<exp)-1;
-  }
-
-  static constexpr  inline std::size_t size(std::size_t size_index_)
-  {
-     return size_index_+1;
-  }
-    
-  static constexpr std::size_t min_size(){return 2;}
+/* Selects parallel construction (see perfect_set). num_threads==0 means
+ * std::thread::hardware_concurrency().
+ */
 
-  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
-  {
-    return hash&size_index_;
-  }
+struct parallel_construction
+{
+  std::size_t num_threads=0;
 };
 
-struct pow2_upper_size_policy
+/* Selects speculative construction (see perfect_set), num_threads as
+ * above.
+ */
+
+struct speculative_construction
 {
-  static constexpr inline std::size_t size_index(std::size_t n)
-  {
-    return sizeof(std::size_t)*CHAR_BIT-
-      (n<=2?1:((std::size_t)(boost::core::bit_width(n-1))));
-  }
+  std::size_t num_threads=0;
+};
 
-  static constexpr inline std::size_t size(std::size_t size_index_)
-  {
-     return std::size_t(1)<<(sizeof(std::size_t)*CHAR_BIT-size_index_);  
-  }
-    
-  static constexpr std::size_t min_size(){return 2;}
+/* Selects bounded-time construction (see perfect_set). */
 
-  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
-  {
-    return hash>>size_index_;
-  }
+struct bounded_construction
+{
+  std::size_t max_trials=std::size_t(1)<<16; /* per bucket */
 };
 
 template<
-  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>
+  typename T,typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>,
+  typename DisplacementSizePolicy=pow2_lower_size_policy,
+  typename ElementSizePolicy=pow2_upper_size_policy,
+  bool CountHits=false,typename Instrumentation=no_instrumentation,
+  typename ScratchAllocator=std::allocator<T>
 >
 class perfect_set
 {
-  using element_array=std::vector<T>;
-  using displacement_size_policy=pow2_lower_size_policy;
-  using element_size_policy=pow2_upper_size_policy;
+  template<typename U>
+  using rebind_alloc=
+    typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  template<typename U>
+  using scratch_alloc=
+    typename std::allocator_traits<ScratchAllocator>::
+      template rebind_alloc<U>;
+  using element_array=std::vector<T,Allocator>;
+  using displacement_size_policy=DisplacementSizePolicy;
+  using element_size_policy=ElementSizePolicy;
+  using displacement_size_index_type=
+    typename displacement_size_policy::size_index_type;
+  using element_size_index_type=
+    typename element_size_policy::size_index_type;
+  using hit_counters_type=
+    std::conditional_t<CountHits,hit_counters,no_hit_counters>;
 
 public:
   static constexpr std::size_t default_lambda=4;
+  static constexpr bool        count_hits=CountHits;
   using key_type=T;
   using value_type=T;
   using hasher=Hash;
   using key_equal=Pred;
+  using allocator_type=Allocator;
+  using scratch_allocator_type=ScratchAllocator;
+  using instrumentation_type=Instrumentation;
   using iterator=typename element_array::const_iterator;
 
+  /* al is used for the lookup tables. Construction scratch memory (and
+   * that of batched lookups and stats()) comes from a default-constructed
+   * scratch_allocator_type, rebound, so that an allocator meant for
+   * long-lived tables, such as huge_page_allocator, is not used for
+   * short-lived buffers.
+   */
+
   template<typename FwdIterator>
   perfect_set(
-    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda)
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
   {
-    while(lambda){
-      if(construct(first,last,lambda))return;
-      lambda/=2;
+    build(first,last,lambda,{});
+  }
+
+  /* Same as above, appending to stats a record of every construction
+   * attempt (see build_statistics).
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,build_statistics& stats,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
+  {
+    build(first,last,lambda,{.stats=&stats});
+  }
+
+  /* Parallel construction: buckets of 2+ elements are taken in the usual
+   * largest-first order from a shared cursor by num_threads threads (the
+   * calling one included), so that at most num_threads-1 of them are
+   * placed ahead of a larger one. Each thread searches displacements
+   * against an atomic occupancy bitmap, claiming the bucket's positions
+   * one by one with atomic fetch_or and releasing them if any is already
+   * taken. Singletons are then placed as usual. The resulting layout
+   * depends on thread scheduling.
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,parallel_construction pc,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
+  {
+    build(first,last,lambda,{.num_threads=resolve_num_threads(pc.num_threads)});
+  }
+
+  /* Speculative construction: rather than trying lambda, lambda/2, ...
+   * down to 1 one after another, tries them all at once from up to
+   * num_threads threads (the calling one included; threads short of
+   * attempts take the next pending lambda, highest first). Elements are
+   * hashed only once for all attempts, and as soon as an attempt
+   * succeeds those with lower lambda are cancelled, so the result is the
+   * same as with sequential construction while the worst-case build time
+   * is that of the slowest attempt rather than of them all. Each running
+   * attempt takes its own element and displacement arrays, released as
+   * soon as the attempt fails or is superseded.
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,speculative_construction sc,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
+  {
+    build_speculatively(
+      first,last,lambda,resolve_num_threads(sc.num_threads));
+  }
+
+  /* Bounded-time construction: buckets not placed within bc.max_trials
+   * displacements are bumped rather than failing the attempt, so that
+   * construction time is linear in the number of elements and there are
+   * no lambda retries. The elements of bumped buckets fill the positions
+   * left free after the singletons, and their positions are kept in a
+   * small overflow table sorted by hash. The displacement of a bumped
+   * bucket is marked so that lookups through it (and only those) binary
+   * search the overflow table. stats() reports how many were bumped.
+   */
+
+  template<typename FwdIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,bounded_construction bc,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
+  {
+    build(first,last,lambda,{.max_trials=bc.max_trials});
+  }
+
+  /* Profile-guided layout: wfirst points to the weights of the elements
+   * of [first,last) (e.g. their query counts in a trace). The buckets with
+   * the highest weight per element, holding up to 1/hot_elements_ratio of
+   * the elements, are placed first, and those with at most
+   * max_hot_bucket_size elements try displacements sending all of them to
+   * a hot region at the start of the element array, twice as large as the
+   * hot elements. Hot singleton buckets then fill the lowest free
+   * positions, heaviest first. Displacement entries stay where the hash
+   * puts them.
+   */
+
+  static constexpr std::size_t hot_elements_ratio=16;
+  static constexpr std::size_t max_hot_bucket_size=6;
+
+  template<typename FwdIterator,typename WeightIterator>
+  requires std::input_iterator<WeightIterator>
+  perfect_set(
+    FwdIterator first,FwdIterator last,WeightIterator wfirst,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    displacements(al),elements(al),overflow(al)
+  {
+    weight_array weights;
+    for(auto it=first;it!=last;++it,++wfirst){
+      weights.push_back(static_cast<double>(*wfirst));
     }
-    throw construction_failure{};
+    build(first,last,lambda,{.weights=&weights});
   }
 
+  perfect_set(const perfect_set& x,const allocator_type& al):
+    h(x.h),pred(x.pred),size_(x.size_),dsize_index(x.dsize_index),
+    displacements(x.displacements,rebind_alloc<displacement_info>(al)),
+    size_index(x.size_index),elements(x.elements,al),
+    overflow(x.overflow,rebind_alloc<overflow_entry>(al)),lambda_(x.lambda_),
+    hits_(x.hits_)
+  {}
+
+  /* Incremental construction from keys arriving one at a time (from a
+   * parser, a socket, a generator), so that they need not be collected
+   * in a forward range first. Keys are hashed as they are added and owned
+   * by the builder; finalize() builds the set from the hashes alone and
+   * then permutes the keys in place into the element array, so that no
+   * copy of them is ever made. Peak memory is thus one copy of the keys
+   * less than with the range constructors, for which the caller's range
+   * and the element array coexist.
+   */
+
+  class builder
+  {
+  public:
+    explicit builder(const allocator_type& al=allocator_type()):
+      keys(al){}
+
+    void reserve(std::size_t n)
+    {
+      keys.reserve(n);
+      hashes.reserve(n);
+    }
+
+    std::size_t size()const{return keys.size();}
+
+    /* keys and hashes are kept the same length: on exception, the key
+     * is not added
+     */
+
+    void add(const value_type& x)
+    {
+      auto hash=h(x);
+      keys.push_back(x);
+      push_hash(hash);
+    }
+
+    void add(value_type&& x)
+    {
+      auto hash=h(x);
+      keys.push_back(std::move(x));
+      push_hash(hash);
+    }
+
+    template<typename InputIterator,typename Sentinel>
+    requires std::input_iterator<InputIterator>&&
+      std::sentinel_for<Sentinel,InputIterator>
+    void add(InputIterator first,Sentinel last)
+    {
+      for(;first!=last;++first)add(*first);
+    }
+
+    template<std::ranges::input_range Range>
+    requires (!std::is_convertible_v<Range,value_type>)
+    void add(Range&& r)
+    {
+      add(std::ranges::begin(r),std::ranges::end(r));
+    }
+
+    /* leaves the builder empty; on exception, keys are kept */
+
+    perfect_set finalize(std::size_t lambda=default_lambda)
+    {
+      return perfect_set{*this,lambda,{}};
+    }
+
+    perfect_set finalize(
+      build_statistics& stats,std::size_t lambda=default_lambda)
+    {
+      return perfect_set{*this,lambda,{.stats=&stats}};
+    }
+
+  private:
+    friend perfect_set;
+    using hash_array=std::vector<std::size_t,scratch_alloc<std::size_t>>;
+
+    void push_hash(std::size_t hash)
+    {
+      try{
+        hashes.push_back(hash);
+      }
+      catch(...){
+        keys.pop_back();
+        throw;
+      }
+    }
+
+    hasher        h;
+    element_array keys;
+    hash_array    hashes;
+  };
+
+  allocator_type get_allocator()const{return elements.get_allocator();}
+  hasher         hash_function()const{return h;}
+
   iterator begin()const{return elements.begin();}
   iterator end()const{return elements.begin()+size_;}
 
+  /* With CountHits, every successful lookup (through any of the find
+   * functions) increments the counter of the slot found, that of
+   * begin()[i] being hits()[i]. hits() is usable on a const set for
+   * snapshots, resets and top-K extraction.
+   */
+
+  hit_counters& hits()const requires count_hits{return hits_;}
+
+  /* Build quality report (see build_quality). Bucket sizes are recovered
+   * by rehashing all the elements, so this takes about as long as size()
+   * lookups. Element bits are sizeof(T) per slot, without any memory
+   * owned by the elements.
+   */
+
+  build_quality stats()const
+  {
+    build_quality res;
+    res.lambda=lambda_;
+    res.num_elements=size_;
+    res.num_buckets=displacements.size();
+    res.parameter_names[0]="d0";
+    res.parameter_names[1]="d1";
+
+    std::vector<std::size_t,scratch_alloc<std::size_t>> bucket_sizes(
+      displacements.size(),0);
+    for(std::size_t i=0;i<size_;++i){
+      ++bucket_sizes[displacement_position(h(elements[i]))];
+    }
+    for(std::size_t b=0;b<displacements.size();++b){
+      const auto& d=displacements[b];
+      if(is_bumped(d))res.add_bumped_bucket(bucket_sizes[b]);
+      else res.add_bucket(
+        bucket_sizes[b],
+        element_size_policy::position(d.first,size_index),d.second>>32);
+    }
+
+    res.space.push_back({
+      "displacements",
+      displacements.capacity()*sizeof(displacement_info)*CHAR_BIT});
+    res.space.push_back({"elements",elements.capacity()*sizeof(T)*CHAR_BIT});
+    if(!overflow.empty()){
+      res.space.push_back({
+        "overflow",overflow.capacity()*sizeof(overflow_entry)*CHAR_BIT});
+    }
+    if constexpr(count_hits){
+      res.space.push_back({
+        "hit counters",hits_.size()*sizeof(std::uint64_t)*CHAR_BIT});
+    }
+    return res;
+  }
+
+  /* lookup counters and latency samples (see lookup_instrumentation) */
+
+  const instrumentation_type& instrumentation()const{return instr;}
+
   template<typename Key>
   BOOST_FORCEINLINE iterator find(const Key& x)const
   {
-    auto hash=h(x);
-    auto pos=element_position(hash,displacements[displacement_position(hash)]);
-    if(pos>=size_||!pred(x,elements[pos]))pos=size_;
-    return elements.begin()+pos;
+    auto t=instr.start();
+    return find_hashed(t,x,h(x));
+  }
+
+  /* hash must be hash_function()(x) */
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    return find_hashed(instr.start(),x,hash);
+  }
+
+  /* Looks up [first,last) in groups of batch_size, prefetching all the
+   * displacements of a group, then all its elements, before comparing.
+   * Results are written to res as with find.
+   */
+
+  static constexpr std::size_t batch_size=16;
+
+  template<typename FwdIterator,typename OutputIterator>
+  OutputIterator find_many(
+    FwdIterator first,FwdIterator last,OutputIterator res)const
+  {
+    return find_many_hashed(
+      first,last,
+      boost::make_transform_iterator(
+        first,[this](const auto& x){return h(x);}),
+      res);
+  }
+
+  /* hfirst points to the hashes of the elements of [first,last) */
+
+  template<
+    typename FwdIterator,typename HashInputIterator,typename OutputIterator
+  >
+  OutputIterator find_many_hashed(
+    FwdIterator first,FwdIterator last,HashInputIterator hfirst,
+    OutputIterator res)const
+  {
+    std::size_t hashes[batch_size],positions[batch_size];
+    while(first!=last){
+      auto        it=first;
+      std::size_t n=0;
+      for(;n<batch_size&&first!=last;++n,++first,++hfirst){
+        hashes[n]=*hfirst;
+        prefetch(&displacements[displacement_position(hashes[n])]);
+      }
+      for(std::size_t i=0;i<n;++i){
+        positions[i]=lookup_position(
+          hashes[i],displacements[displacement_position(hashes[i])]);
+        if(positions[i]<size_)prefetch(&elements[positions[i]]);
+      }
+      for(std::size_t i=0;i<n;++i,++it){
+        *res++=elements.begin()+complete_lookup(*it,positions[i]);
+      }
+    }
+    return res;
+  }
+
+  /* Same as find, suspending after prefetching the displacement and then
+   * the element (see lookup_task and lookup_scheduler).
+   */
+
+  template<typename Key>
+  lookup_task<iterator> co_find(const Key& x)const
+  {
+    auto  hash=h(x);
+    auto& d=displacements[displacement_position(hash)];
+    prefetch(&d);
+    co_await std::suspend_always{};
+    auto pos=lookup_position(hash,d);
+    if(pos<size_){
+      prefetch(&elements[pos]);
+      co_await std::suspend_always{};
+    }
+    co_return elements.begin()+complete_lookup(x,pos);
+  }
+
+  /* For very large batches: all queries are hashed and radix-partitioned
+   * by the region of the displacement array they access, displacements
+   * are then read partition by partition, and the same is done for the
+   * element array. Regions are about partition_region_size bytes, so that
+   * the accesses within a partition stay in a few pages. Results are
+   * scattered back to res in query order. Uses O(last-first) scratch
+   * memory.
+   */
+
+  static constexpr std::size_t partition_region_size=4096;
+
+  template<typename RandomAccessIterator,typename RandomAccessOutputIterator>
+  void find_partitioned(
+    RandomAccessIterator first,RandomAccessIterator last,
+    RandomAccessOutputIterator res)const
+  {
+    auto n=static_cast<std::size_t>(last-first);
+    probe_array probes(n),buffer(n);
+    for(std::size_t i=0;i<n;++i)probes[i]={h(first[i]),i};
+
+    auto dshift=partition_shift(sizeof(displacement_info));
+    radix_partition(
+      probes,buffer,
+      partition_bits(displacements.size(),dshift),
+      [&](const probe& p){return displacement_position(p.x)>>dshift;});
+    for(auto& p:probes){
+      p.x=lookup_position(p.x,displacements[displacement_position(p.x)]);
+      if(p.x>size_)p.x=size_;
+    }
+
+    auto eshift=partition_shift(sizeof(value_type));
+    radix_partition(
+      probes,buffer,partition_bits(size_+1,eshift),
+      [&](const probe& p){return p.x>>eshift;});
+    for(const auto& p:probes){
+      res[p.index]=elements.begin()+complete_lookup(first[p.index],p.x);
+    }
   }
 
 private:
   using displacement_info=std::pair<std::size_t,std::size_t>;
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(
+    typename instrumentation_type::token t,const Key& x,std::size_t hash)const
+  {
+    auto pos=complete_lookup(
+      t,x,lookup_position(hash,displacements[displacement_position(hash)]));
+    return elements.begin()+pos;
+  }
+
+  /* checks x against the element at pos (if any) and accounts for the
+   * outcome, as a batched lookup unless given a token: returns pos if
+   * found, size_ otherwise
+   */
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t complete_lookup(
+    const Key& x,std::size_t pos)const
+  {
+    auto o=lookup_outcome::hit;
+    pos=complete_lookup(x,pos,o);
+    instr.count(o);
+    return pos;
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t complete_lookup(
+    typename instrumentation_type::token t,const Key& x,std::size_t pos)const
+  {
+    auto o=lookup_outcome::hit;
+    pos=complete_lookup(x,pos,o);
+    instr.finish(t,o);
+    return pos;
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::size_t complete_lookup(
+    const Key& x,std::size_t pos,lookup_outcome& o)const
+  {
+    if(pos>=size_){
+      o=lookup_outcome::rejected;
+      return size_;
+    }
+    if(!pred(x,elements[pos])){
+      o=lookup_outcome::miss;
+      return size_;
+    }
+    hits_.increment(pos);
+    return pos;
+  }
+  struct probe
+  {
+    std::size_t x; /* hash, then element position */
+    std::size_t index;
+  };
+  using probe_array=std::vector<probe,scratch_alloc<probe>>;
+
+  /* positions are grouped into regions of 2^shift positions */
+
+  static std::size_t partition_shift(std::size_t entry_size)
+  {
+    auto entries=(std::max)(
+      partition_region_size/entry_size,std::size_t(1));
+    return static_cast<std::size_t>(boost::core::bit_width(entries-1));
+  }
+
+  static std::size_t partition_bits(std::size_t n,std::size_t shift)
+  {
+    return static_cast<std::size_t>(
+      boost::core::bit_width((n?n-1:0)>>shift));
+  }
+
+  /* LSD radix sort on bits-bit keys with 8-bit digits, so that every pass
+   * scatters into at most 256 partitions.
+   */
+
+  template<typename Key>
+  static void radix_partition(
+    probe_array& probes,probe_array& buffer,std::size_t bits,Key key)
+  {
+    static constexpr std::size_t digit_bits=8,
+                                 num_digits=std::size_t(1)<<digit_bits;
+
+    for(std::size_t shift=0;shift<bits;shift+=digit_bits){
+      std::size_t counts[num_digits+1]={};
+      for(const auto& p:probes)++counts[((key(p)>>shift)&(num_digits-1))+1];
+      std::partial_sum(counts,counts+num_digits+1,counts);
+      for(const auto& p:probes){
+        buffer[counts[(key(p)>>shift)&(num_digits-1)]++]=p;
+      }
+      probes.swap(buffer);
+    }
+  }
+
   template<typename FwdIterator>
   struct bucket_node
   {
@@ -148,47 +636,262 @@ private:
     std::size_t               size=0;
   };
 
+  using weight_array=std::vector<double,scratch_alloc<double>>;
+
+  /* construction settings other than lambda */
+
+  struct build_options
+  {
+    const weight_array*      weights=nullptr;
+    build_statistics*        stats=nullptr;
+    std::size_t              num_threads=1; /* for concurrent placement */
+    const std::size_t*       hashes=nullptr; /* of [first,last), if known */
+    const std::atomic<bool>* cancel=nullptr; /* polled between buckets */
+    std::size_t              max_trials=std::size_t(-1); /* then bumped */
+    bool                     store_elements=true; /* else left empty */
+  };
+
+  static std::size_t resolve_num_threads(std::size_t num_threads)
+  {
+    return num_threads?
+      num_threads:
+      (std::max)(1u,std::thread::hardware_concurrency());
+  }
+
+  /* empty set for speculative construction attempts */
+
+  explicit perfect_set(const allocator_type& al):
+    displacements(al),elements(al),overflow(al){}
+
+  /* Builds from the keys and hashes of b, then takes the keys over,
+   * sending each to its position by cycle-following swaps. Positions
+   * overwrite b.hashes, which are no longer needed.
+   */
+
+  perfect_set(builder& b,std::size_t lambda,build_options opts):
+    h(b.h),displacements(b.keys.get_allocator()),
+    elements(b.keys.get_allocator()),overflow(b.keys.get_allocator())
+  {
+    auto& positions=b.hashes;
+    opts.hashes=positions.data();
+    opts.store_elements=false;
+    build(b.keys.begin(),b.keys.end(),lambda,opts);
+
+    for(auto& x:positions){
+      x=lookup_position(x,displacements[displacement_position(x)]);
+    }
+    for(std::size_t i=0;i<size_;++i){
+      while(positions[i]!=i){
+        auto j=positions[i];
+        std::swap(b.keys[i],b.keys[j]);
+        std::swap(positions[i],positions[j]);
+      }
+    }
+    elements=std::move(b.keys);
+    elements.shrink_to_fit();
+    b.keys.clear();
+    positions.clear();
+  }
+
+  /* tries construct with lambda, lambda/2, ... down to 1 */
+
+  template<typename FwdIterator>
+  void build(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    const build_options& opts)
+  {
+    while(lambda){
+      if(construct(first,last,lambda,opts)){
+        lambda_=lambda;
+        hits_=hit_counters_type(size_);
+        return;
+      }
+      lambda/=2;
+    }
+    throw construction_failure{};
+  }
+
   template<typename FwdIterator>
-  bool construct(FwdIterator first,FwdIterator last,std::size_t lambda)
+  void build_speculatively(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    std::size_t num_threads)
   {
-    using bucket_node_array=std::vector<bucket_node<FwdIterator>>;
-    using bucket_array=std::vector<bucket_entry<FwdIterator>>;
+    using hash_array=std::vector<std::size_t,scratch_alloc<std::size_t>>;
+    using attempt_array=std::vector<
+      std::unique_ptr<perfect_set>,
+      scratch_alloc<std::unique_ptr<perfect_set>>>;
+
+    enum attempt_state{pending,succeeded,failed};
+
+    struct attempt_control
+    {
+      std::size_t        lambda;
+      std::atomic<bool>  cancel{false};
+      attempt_state      state=pending;
+      std::exception_ptr exception;
+    };
+
+    auto al=get_allocator();
+    std::size_t num_attempts=0;
+    for(auto l=lambda;l;l/=2)++num_attempts;
+    if(num_attempts<=1||num_threads<=1){
+      build(first,last,lambda,{});
+      return;
+    }
+
+    hash_array hashes;
+    hashes.reserve(static_cast<std::size_t>(std::distance(first,last)));
+    for(auto it=first;it!=last;++it)hashes.push_back(h(*it));
+
+    /* attempts are listed and started in decreasing lambda order */
+
+    std::unique_ptr<attempt_control[]> controls{
+      new attempt_control[num_attempts]};
+    attempt_array attempts;
+    attempts.reserve(num_attempts);
+    for(std::size_t i=0;i<num_attempts;++i){
+      controls[i].lambda=lambda>>i;
+      attempts.emplace_back(new perfect_set(al));
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::mutex               m;
+    auto work=[&]{
+      for(;;){
+        auto i=next.fetch_add(1,std::memory_order_relaxed);
+        if(i>=num_attempts)return;
+
+        auto& c=controls[i];
+        bool  res=false;
+        if(!c.cancel.load(std::memory_order_relaxed)){
+          try{
+            res=attempts[i]->construct(
+              first,last,c.lambda,
+              {.hashes=hashes.data(),.cancel=&c.cancel});
+          }
+          catch(...){
+            c.exception=std::current_exception();
+          }
+        }
+
+        /* arrays of attempts that can no longer be used are released
+         * right away, so as not to hold them until all attempts finish
+         */
+
+        std::lock_guard<std::mutex> lck{m};
+        res=res&&!c.cancel.load(std::memory_order_relaxed);
+        c.state=res?succeeded:failed;
+        if(res){
+          for(auto j=i+1;j<num_attempts;++j){
+            controls[j].cancel.store(true,std::memory_order_relaxed);
+            if(controls[j].state==succeeded)attempts[j].reset();
+          }
+        }
+        else attempts[i].reset();
+      }
+    };
+
+    /* if a thread can't be started, the attempts are run by those
+     * already started plus the calling one
+     */
+
+    std::vector<std::thread> threads;
+    auto                     num_workers=(std::min)(num_threads,num_attempts);
+    threads.reserve(num_workers-1);
+    try{
+      for(std::size_t t=1;t<num_workers;++t)threads.emplace_back(work);
+    }
+    catch(const std::system_error&){}
+    work();
+    for(auto& t:threads)t.join();
+
+    for(std::size_t i=0;i<num_attempts;++i){
+      auto& c=controls[i];
+      if(c.exception)std::rethrow_exception(c.exception);
+      if(c.state==succeeded){
+        auto& x=*attempts[i];
+        size_=x.size_;
+        dsize_index=x.dsize_index;
+        displacements=std::move(x.displacements);
+        size_index=x.size_index;
+        elements=std::move(x.elements);
+        overflow=std::move(x.overflow);
+        lambda_=c.lambda;
+        hits_=hit_counters_type(size_);
+        return;
+      }
+    }
+    throw construction_failure{};
+  }
+
+  template<typename FwdIterator>
+  bool construct(
+    FwdIterator first,FwdIterator last,std::size_t lambda,
+    const build_options& opts)
+  {
+    using bucket_node_array=std::vector<
+      bucket_node<FwdIterator>,scratch_alloc<bucket_node<FwdIterator>>>;
+    using bucket_array=std::vector<
+      bucket_entry<FwdIterator>,scratch_alloc<bucket_entry<FwdIterator>>>;
+    using index_array=std::vector<std::size_t,scratch_alloc<std::size_t>>;
+    using bitset=boost::dynamic_bitset<
+      unsigned long,scratch_alloc<unsigned long>>;
 
     size_=static_cast<std::size_t>(std::distance(first,last));
     dsize_index=displacement_size_policy::size_index(size_/lambda);
     displacements.resize(displacement_size_policy::size(dsize_index));
     displacements.shrink_to_fit();
 
-    /* extended_size is a power of two strictly no smaller than the element
-     * array size. Construction and lookup work as if with a virtual extended
-     * array whose positions from size_ are taken up. 
+    /* extended_size is no smaller than the element array size (with
+     * pow2_upper_size_policy, the smallest power of two no smaller).
+     * Construction and lookup work as if with a virtual extended array
+     * whose positions from size_ are taken up. 
      */
 
     size_index=element_size_policy::size_index(size_);
     auto extended_size=element_size_policy::size(size_index);
-    elements.resize(size_);
-    elements.shrink_to_fit();
+    if(opts.store_elements){
+      elements.resize(size_);
+      elements.shrink_to_fit();
+    }
+    overflow.clear();
 
+    build_recorder rec(opts.stats,lambda,size_,displacements.size());
+    rec.phase(build_phase::hashing);
     bucket_node_array bucket_nodes;
-    bucket_array      buckets(displacements.size());
     bucket_nodes.reserve(size_);
-    for(auto it=first;it!=last;++it){
-      auto   hash=h(*it);
-      auto  &root=buckets[displacement_position(hash)];
+    if(opts.hashes){
+      auto phash=opts.hashes;
+      for(auto it=first;it!=last;++it)bucket_nodes.push_back({it,*phash++});
+    }
+    else{
+      for(auto it=first;it!=last;++it)bucket_nodes.push_back({it,h(*it)});
+    }
+
+    rec.phase(build_phase::bucketing);
+    bucket_array buckets(displacements.size());
+    for(auto& node:bucket_nodes){
+      auto  &root=buckets[displacement_position(node.hash)];
       auto **ppnode=&root.begin;
       while(*ppnode){
-        if((*ppnode)->hash==hash){
-          if(pred(*((*ppnode)->it),*(it)))throw duplicate_element{};
-          else                            throw duplicate_hash{};
+        if((*ppnode)->hash==node.hash){
+          if(pred(*((*ppnode)->it),*(node.it))){
+            rec.fail(build_failure_reason::duplicate_element);
+            throw duplicate_element{};
+          }
+          else{
+            rec.fail(build_failure_reason::duplicate_hash);
+            throw duplicate_hash{};
+          }
         }
         ppnode=&(*ppnode)->next;
       }
-      bucket_nodes.push_back({it,hash});
-      *ppnode=&bucket_nodes.back();
+      *ppnode=&node;
       ++root.size;
     }
 
-    std::vector<std::size_t> sorted_bucket_indices(buckets.size());
+    rec.phase(build_phase::sorting);
+    index_array sorted_bucket_indices(buckets.size());
     std::iota(sorted_bucket_indices.begin(),sorted_bucket_indices.end(),0u);
     std::sort(
       sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
@@ -196,66 +899,106 @@ private:
         return buckets[i1].size>buckets[i2].size;
       });
 
-    boost::dynamic_bitset<>  mask;
+    bitset      hot;
+    std::size_t hot_region=0;
+    if(opts.weights){
+      hot_region=prioritize_hot_buckets(
+        buckets,bucket_nodes,*opts.weights,sorted_bucket_indices,hot);
+    }
+
+    rec.phase(build_phase::placement);
+    bitset      mask;
     mask.resize(size_,true); /* true --> available */
-    std::vector<std::size_t> bucket_positions;
-#ifdef HD_PERFECT_SET_TRACE
+    index_array bucket_positions;
+    index_array bumped_buckets;
     std::size_t num_inserted=0;
-#endif
 
 #if 1
     std::size_t i=0;
+    if(opts.num_threads>1&&!place_concurrently(
+         buckets,sorted_bucket_indices,extended_size,opts.num_threads,
+         opts.store_elements,mask,i,num_inserted,rec))return false;
+
+    /* with concurrent placement, i is already at the first singleton */
+
     for(;i<buckets.size();++i){
       const auto& bucket=buckets[sorted_bucket_indices[i]];
       if(bucket.size<=1)break; /* on to buckets of size 1 */
 
-#ifdef HD_PERFECT_SET_TRACE
-      if(i%10000==0)std::cout<<i<<":\t"<<bucket.size<<"\t"<<num_inserted<<"\n";
+      if(opts.cancel&&opts.cancel->load(std::memory_order_relaxed)){
+        return false;
+      }
+      rec.progress(i,num_inserted);
       num_inserted+=bucket.size;
-#endif
-
-      for(std::size_t d0=0;d0<extended_size;++d0){
-        for(std::size_t d1=0;d1<extended_size;++d1){
-          /* this calculation critically depends on displacement_size_policy */
-          displacement_info d={d0<<size_index,(d1<<32)+1};
 
-          bucket_positions.clear();
-          for(auto pnode=bucket.begin;pnode;pnode=pnode->next){
-            auto pos=element_position(pnode->hash,d);
-            if(pos>=size_||!mask[pos]){
-              for(auto pos2:bucket_positions)mask[pos2]=true;
-              goto next_displacement;
+      /* tries up to max_trials displacements sending the bucket below
+       * pos_limit
+       */
+
+      std::uint64_t bucket_trials=0;
+      auto place=[&](std::size_t pos_limit,std::size_t max_trials){
+        std::size_t trials=0;
+        for(std::size_t d0=0;d0<extended_size;++d0){
+          for(std::size_t d1=0;d1<extended_size;++d1){
+            if(trials++==max_trials)return false;
+            ++bucket_trials;
+            displacement_info d={
+              element_size_policy::preimage(d0,size_index),(d1<<32)+1};
+
+            bucket_positions.clear();
+            for(auto pnode=bucket.begin;pnode;pnode=pnode->next){
+              auto pos=element_position(pnode->hash,d);
+              if(pos>=pos_limit||!mask[pos]){
+                for(auto pos2:bucket_positions)mask[pos2]=true;
+                goto next_displacement;
+              }
+              mask[pos]=false;
+              bucket_positions.push_back(pos);
             }
-            mask[pos]=false;
-            bucket_positions.push_back(pos);
-          }
-          displacements[sorted_bucket_indices[i]]=d;
-          {
-            auto pnode=bucket.begin;
-            for(auto pos:bucket_positions){
-              elements[pos]=*(pnode->it);
-              pnode=pnode->next;
+            displacements[sorted_bucket_indices[i]]=d;
+            if(opts.store_elements){
+              auto pnode=bucket.begin;
+              for(auto pos:bucket_positions){
+                elements[pos]=*(pnode->it);
+                pnode=pnode->next;
+              }
             }
+            return true;
+            next_displacement:;
           }
-          goto next_bucket;
-          next_displacement:;
         }
+        return false;
+      };
+
+      if(!(hot_region&&hot[sorted_bucket_indices[i]]&&
+           bucket.size<=max_hot_bucket_size&&
+           place(hot_region,hot_trials(bucket.size,hot_region)))&&
+         !place(size_,opts.max_trials)){
+        if(opts.max_trials!=std::size_t(-1)){
+          bumped_buckets.push_back(sorted_bucket_indices[i]);
+          rec.bump(bucket.size);
+          continue;
+        }
+        rec.fail(
+          build_failure_reason::bucket_unplaceable,bucket.size,bucket_trials);
+        return false;
       }
-      return false;
-    next_bucket:;
+      rec.trials(bucket.size,bucket_trials);
     }
 #else
-    std::vector<std::size_t> bucket_muls;
+    index_array bucket_muls;
     std::size_t i=0;
     for(;i<buckets.size();++i){
       const auto& bucket=buckets[sorted_bucket_indices[i]];
       if(bucket.size<=1)break; /* on to buckets of size 1 */
 
-#ifdef HD_PERFECT_SET_TRACE
-      if(i%10000==0)std::cout<<i<<":\t"<<bucket.size<<"\t"<<num_inserted<<"\n";
+      if(opts.cancel&&opts.cancel->load(std::memory_order_relaxed)){
+        return false;
+      }
+      rec.progress(i,num_inserted);
       num_inserted+=bucket.size;
-#endif
 
+      std::uint64_t bucket_trials=0;
       for(std::size_t d1=0;d1<extended_size;++d1){
         displacement_info d={0,(d1<<32)+1};
         bucket_muls.clear();
@@ -264,6 +1007,7 @@ private:
         }
 
         for(auto d0=mask.find_first();d0<size_;d0=mask.find_next(d0)){
+          ++bucket_trials;
           d.first=(d0-bucket_muls[0])<<size_index;
           bucket_positions.clear();
           for(auto mul:bucket_muls){
@@ -279,13 +1023,16 @@ private:
           displacements[sorted_bucket_indices[i]]=d;
           for(auto pnode=bucket.begin;pnode;pnode=pnode->next){
             auto pos=element_position(pnode->hash,d);
-            elements[pos]=*(pnode->it);
+            if(opts.store_elements)elements[pos]=*(pnode->it);
             mask[pos]=false;
           }
+          rec.trials(bucket.size,bucket_trials);
           goto next_bucket;
           next_displacement:;
         }
       }
+      rec.fail(
+        build_failure_reason::bucket_unplaceable,bucket.size,bucket_trials);
       return false;
     next_bucket:;
     }
@@ -293,48 +1040,284 @@ private:
 
     /* buckets of size <=1 */
 
+    rec.phase(build_phase::singletons);
     auto pos=mask.find_first();
     for(;i<buckets.size();++i){
       const auto& bucket=buckets[sorted_bucket_indices[i]];
       if(!bucket.size)break; /* remaining buckets also empty */
 
-#ifdef HD_PERFECT_SET_TRACE
-      if(i%10000==0)std::cout<<i<<":\t"<<bucket.size<<"\t"<<num_inserted<<"\n";
-      num_inserted+=bucket.size;
-#endif
-      /* this calculation critically depends on displacement_size_policy */
-      displacements[sorted_bucket_indices[i]]={pos<<size_index,0};
-      elements[pos]=*(bucket.begin->it);
+      rec.progress(i,num_inserted++);
+      displacements[sorted_bucket_indices[i]]={
+        element_size_policy::preimage(pos,size_index),0};
+      if(opts.store_elements)elements[pos]=*(bucket.begin->it);
       mask[pos]=false;
       pos=mask.find_next(pos);
     }
 
+    /* elements of bumped buckets take the remaining positions */
+
+    for(auto b:bumped_buckets){
+      displacements[b]=bumped_displacement;
+      for(auto pnode=buckets[b].begin;pnode;pnode=pnode->next){
+        rec.progress(i,num_inserted++);
+        if(opts.store_elements)elements[pos]=*(pnode->it);
+        overflow.push_back({pnode->hash,pos});
+        mask[pos]=false;
+        pos=mask.find_next(pos);
+      }
+    }
+    std::sort(overflow.begin(),overflow.end());
+
     for(;i<buckets.size();++i){
       /* send all empty buckets off range */
       displacements[sorted_bucket_indices[i]]={~std::size_t(0),0};
     }
 
+    rec.succeed();
     return true;
   }
 
+  /* Places the buckets of 2+ elements for parallel construction, leaving
+   * mask, i and num_inserted as the sequential loop would. Threads are
+   * not started for fewer than min_buckets_per_thread buckets each.
+   */
+
+  static constexpr std::size_t min_buckets_per_thread=1024;
+
+  template<typename BucketArray,typename IndexArray,typename Bitset>
+  bool place_concurrently(
+    const BucketArray& buckets,const IndexArray& sorted_bucket_indices,
+    std::size_t extended_size,std::size_t num_threads,bool store_elements,
+    Bitset& mask,std::size_t& i,std::size_t& num_inserted,
+    build_recorder& rec)
+  {
+    using word_array=std::vector<
+      std::atomic<std::uint64_t>,scratch_alloc<std::atomic<std::uint64_t>>>;
+    using trial_array=std::vector<std::uint64_t,scratch_alloc<std::uint64_t>>;
+
+    auto num_multi=static_cast<std::size_t>(
+      std::find_if(
+        sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
+        [&](std::size_t b){return buckets[b].size<=1;})-
+      sorted_bucket_indices.begin());
+    num_threads=(std::max)(
+      std::size_t(1),
+      (std::min)(num_threads,num_multi/min_buckets_per_thread));
+
+    word_array               occupied((size_+63)/64);
+    trial_array              trials(num_multi,0);
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool>        failed{false};
+    std::size_t              failed_bucket_size=0;
+    std::uint64_t            failed_bucket_trials=0;
+
+    /* the plain load avoids read-modify-writes on taken positions */
+
+    auto claim=[&](std::size_t pos){
+      auto  bit=std::uint64_t(1)<<(pos%64);
+      auto& word=occupied[pos/64];
+      return !(word.load(std::memory_order_relaxed)&bit)&&
+             !(word.fetch_or(bit,std::memory_order_relaxed)&bit);
+    };
+    auto release=[&](std::size_t pos){
+      occupied[pos/64].fetch_and(
+        ~(std::uint64_t(1)<<(pos%64)),std::memory_order_relaxed);
+    };
+
+    auto work=[&]{
+      std::vector<std::size_t,scratch_alloc<std::size_t>> bucket_positions;
+      for(;;){
+        auto j=next.fetch_add(1,std::memory_order_relaxed);
+        if(j>=num_multi||failed.load(std::memory_order_relaxed))return;
+
+        auto        b=sorted_bucket_indices[j];
+        const auto& bucket=buckets[b];
+        for(std::size_t d0=0;d0<extended_size;++d0){
+          for(std::size_t d1=0;d1<extended_size;++d1){
+            ++trials[j];
+            displacement_info d={
+              element_size_policy::preimage(d0,size_index),(d1<<32)+1};
+
+            bucket_positions.clear();
+            for(auto pnode=bucket.begin;pnode;pnode=pnode->next){
+              auto pos=element_position(pnode->hash,d);
+              if(pos>=size_||!claim(pos)){
+                for(auto pos2:bucket_positions)release(pos2);
+                goto next_displacement;
+              }
+              bucket_positions.push_back(pos);
+            }
+            displacements[b]=d;
+            if(store_elements){
+              auto pnode=bucket.begin;
+              for(auto pos:bucket_positions){
+                elements[pos]=*(pnode->it);
+                pnode=pnode->next;
+              }
+            }
+            goto next_bucket;
+            next_displacement:;
+          }
+        }
+        if(!failed.exchange(true)){
+          failed_bucket_size=bucket.size;
+          failed_bucket_trials=trials[j];
+        }
+        return;
+      next_bucket:;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for(std::size_t t=1;t<num_threads;++t)threads.emplace_back(work);
+    work();
+    for(auto& t:threads)t.join();
+
+    if(failed){
+      rec.fail(
+        build_failure_reason::bucket_unplaceable,
+        failed_bucket_size,failed_bucket_trials);
+      return false;
+    }
+    for(;i<num_multi;++i){
+      const auto& bucket=buckets[sorted_bucket_indices[i]];
+      num_inserted+=bucket.size;
+      rec.trials(bucket.size,trials[i]);
+    }
+    for(std::size_t pos=0;pos<size_;++pos){
+      if(occupied[pos/64].load(std::memory_order_relaxed)&
+         (std::uint64_t(1)<<(pos%64)))mask[pos]=false;
+    }
+    return true;
+  }
+
+  /* Marks the hot buckets and moves them to the front of their size
+   * class (multi-element or singleton) in sorted_bucket_indices, hot
+   * singletons in decreasing weight order. Returns the size of the hot
+   * region.
+   */
+
+  template<
+    typename BucketArray,typename BucketNodeArray,
+    typename IndexArray,typename Bitset
+  >
+  std::size_t prioritize_hot_buckets(
+    const BucketArray& buckets,const BucketNodeArray& bucket_nodes,
+    const weight_array& weights,IndexArray& sorted_bucket_indices,
+    Bitset& hot)const
+  {
+    weight_array bucket_weights(buckets.size(),0.0);
+    for(std::size_t b=0;b<buckets.size();++b){
+      for(auto pnode=buckets[b].begin;pnode;pnode=pnode->next){
+        bucket_weights[b]+=weights[pnode-bucket_nodes.data()];
+      }
+    }
+    auto heavier=[&](std::size_t b1,std::size_t b2){
+      return bucket_weights[b1]*buckets[b2].size>
+             bucket_weights[b2]*buckets[b1].size;
+    };
+
+    auto first_singleton=std::find_if(
+      sorted_bucket_indices.begin(),sorted_bucket_indices.end(),
+      [&](std::size_t b){return buckets[b].size<=1;});
+    auto first_empty=std::find_if(
+      first_singleton,sorted_bucket_indices.end(),
+      [&](std::size_t b){return buckets[b].size==0;});
+
+    IndexArray by_weight(sorted_bucket_indices.begin(),first_empty);
+    std::stable_sort(by_weight.begin(),by_weight.end(),heavier);
+    hot.resize(buckets.size(),false);
+    std::size_t hot_elements=0;
+    for(auto b:by_weight){
+      if(bucket_weights[b]<=0)break;
+      if(hot_elements+buckets[b].size>size_/hot_elements_ratio)continue;
+      hot[b]=true;
+      hot_elements+=buckets[b].size;
+    }
+
+    auto is_hot=[&](std::size_t b){return (bool)hot[b];};
+    std::stable_partition(
+      sorted_bucket_indices.begin(),first_singleton,is_hot);
+    auto last_hot_singleton=std::stable_partition(
+      first_singleton,first_empty,is_hot);
+    std::stable_sort(first_singleton,last_hot_singleton,heavier);
+    return (std::min)(size_,2*hot_elements);
+  }
+
+  /* enough trials to place a bucket of size n in the hot region with
+   * high probability, at most 2^16
+   */
+
+  std::size_t hot_trials(std::size_t n,std::size_t hot_region)const
+  {
+    std::size_t trials=16;
+    while(n--&&trials<(std::size_t(1)<<16))trials*=size_/hot_region;
+    return (std::min)(trials,std::size_t(1)<<16);
+  }
+
   std::size_t displacement_position(std::size_t hash)const
   {
     return displacement_size_policy::position(hash,dsize_index);
   }
 
+  /* Multiplier (d.second) marking bumped buckets: those of other buckets
+   * are either odd or zero.
+   */
+
+  static constexpr std::size_t       bumped_multiplier=2;
+  static constexpr displacement_info bumped_displacement=
+    {0,bumped_multiplier};
+
+  static bool is_bumped(const displacement_info& d)
+  {
+    return d.second==bumped_multiplier;
+  }
+
+  /* element position for lookup, off range if none. Sets with no bumped
+   * buckets have an empty overflow table and never check the marker.
+   */
+
+  BOOST_FORCEINLINE std::size_t lookup_position(
+    std::size_t hash,const displacement_info& d)const
+  {
+    if(BOOST_UNLIKELY(!overflow.empty()&&is_bumped(d))){
+      return overflow_position(hash);
+    }
+    return element_position(hash,d);
+  }
+
+  BOOST_NOINLINE std::size_t overflow_position(std::size_t hash)const
+  {
+    auto it=std::lower_bound(
+      overflow.begin(),overflow.end(),overflow_entry{hash,0});
+    return it!=overflow.end()&&it->first==hash?it->second:size_;
+  }
+
   std::size_t element_position(
     std::size_t hash,const displacement_info& d)const
   {
     return element_size_policy::position(d.first+d.second*hash,size_index);
   }
 
-  hasher                         h;
-  key_equal                      pred;
-  std::size_t                    size_;
-  std::size_t                    dsize_index;
-  std::vector<displacement_info> displacements;
-  std::size_t                    size_index;
-  element_array                  elements;
+  using displacement_array=
+    std::vector<displacement_info,rebind_alloc<displacement_info>>;
+  using overflow_entry=std::pair<std::size_t,std::size_t>; /* hash,pos */
+  using overflow_array=
+    std::vector<overflow_entry,rebind_alloc<overflow_entry>>;
+
+  hasher                       h;
+  key_equal                    pred;
+  std::size_t                  size_;
+  displacement_size_index_type dsize_index;
+  displacement_array           displacements;
+  element_size_index_type      size_index;
+  element_array                elements;
+  overflow_array               overflow;
+  std::size_t                  lambda_;
+  [[no_unique_address]] mutable
+  hit_counters_type            hits_;
+  [[no_unique_address]]
+  instrumentation_type         instr;
 };
 
 /* some mixers */
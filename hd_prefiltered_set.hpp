@@ -0,0 +1,164 @@
+/* Pre-hash rejection filter over perfect sets of strings.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_PREFILTERED_SET_HPP
+#define HD_PREFILTERED_SET_HPP
+
+#include <algorithm>
+#include <boost/config.hpp>
+#include <boost/core/bit.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "hd_perfect_set.hpp"
+
+namespace hd{
+
+/* Rejects most string queries not in the construction set by looking only
+ * at their length and their first (up to) 8 bytes, so that the hash
+ * function needn't be run at all:
+ *   - a 64-bit bitmap of the lengths present (lengths >=63 share bit 63),
+ *   - a bitmap indexed by a multiplicative hash of the first word of the
+ *     string combined with its length, sized at 8 to 16 bits per element
+ *     (between 2^6 and 2^16 bits in total), which rejects misses differing
+ *     from all elements of the same length in their first 8 bytes.
+ * False positives are simply passed on to the underlying lookup.
+ */
+
+template<typename Allocator=std::allocator<std::uint64_t>>
+class string_prefilter
+{
+  using word_allocator_type=typename std::allocator_traits<Allocator>::
+    template rebind_alloc<std::uint64_t>;
+
+public:
+  static constexpr std::size_t min_word_bits=6;
+  static constexpr std::size_t max_word_bits=16;
+
+  template<typename FwdIterator>
+  string_prefilter(
+    FwdIterator first,FwdIterator last,const Allocator& al=Allocator()):
+    words(word_allocator_type(al))
+  {
+    auto n=static_cast<std::size_t>(std::distance(first,last));
+    std::size_t word_bits=std::clamp<std::size_t>(
+      boost::core::bit_width(n*8),min_word_bits,max_word_bits);
+    shift=64-word_bits;
+    words.resize((std::size_t(1)<<word_bits)/64,0);
+    for(auto it=first;it!=last;++it){
+      lengths|=length_bit(it->size());
+      auto pos=word_position(*it);
+      words[pos/64]|=std::uint64_t(1)<<(pos%64);
+    }
+  }
+
+  std::size_t size_in_bits()const{return 64+words.size()*64;}
+
+  template<typename String>
+  BOOST_FORCEINLINE bool may_contain(const String& x)const
+  {
+    if(!(lengths&length_bit(x.size())))return false;
+    auto pos=word_position(x);
+    return words[pos/64]&(std::uint64_t(1)<<(pos%64));
+  }
+
+private:
+  static std::uint64_t length_bit(std::size_t n)
+  {
+    return std::uint64_t(1)<<(std::min)(n,std::size_t(63));
+  }
+
+  template<typename String>
+  BOOST_FORCEINLINE std::size_t word_position(const String& x)const
+  {
+    return static_cast<std::size_t>(
+      ((first_word(x.data(),x.size())^x.size())*0x9e3779b97f4a7c15ull)>>
+      shift);
+  }
+
+  /* same loading scheme as mulxp3_string_hash for its last block */
+
+  static BOOST_FORCEINLINE std::uint64_t first_word(
+    const char* p,std::size_t n)
+  {
+    if(n>=8)return read64le(p);
+    else if(n>=4){
+      return (std::uint64_t)read32le(p+n-4)<<(n-4)*8|read32le(p);
+    }
+    else if(n>=1){
+      std::size_t const x1=(n-1)&2;
+      std::size_t const x2=n>>1;
+      return
+        (std::uint64_t)static_cast<unsigned char>(p[x1])<<x1*8|
+        (std::uint64_t)static_cast<unsigned char>(p[x2])<<x2*8|
+        (std::uint64_t)static_cast<unsigned char>(p[0]);
+    }
+    else return 0;
+  }
+
+  using word_array=std::vector<std::uint64_t,word_allocator_type>;
+
+  std::uint64_t lengths=0;
+  std::size_t   shift;
+  word_array    words;
+};
+
+/* Set with a string_prefilter checked before any call to Set::find. */
+
+template<typename Set>
+class prefiltered_set
+{
+public:
+  using set_type=Set;
+  using key_type=typename set_type::key_type;
+  using value_type=typename set_type::value_type;
+  using hasher=typename set_type::hasher;
+  using key_equal=typename set_type::key_equal;
+  using allocator_type=typename set_type::allocator_type;
+  using iterator=typename set_type::iterator;
+  static constexpr std::size_t default_lambda=set_type::default_lambda;
+
+  template<typename FwdIterator>
+  prefiltered_set(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    s(first,last,lambda,al),prefilter(first,last,al)
+  {}
+
+  allocator_type get_allocator()const{return s.get_allocator();}
+  hasher         hash_function()const{return s.hash_function();}
+
+  const set_type&                         set()const{return s;}
+  const string_prefilter<allocator_type>& filter()const{return prefilter;}
+
+  iterator begin()const{return s.begin();}
+  iterator end()const{return s.end();}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
+  {
+    if(!prefilter.may_contain(x))return s.end();
+    return s.find(x);
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    if(!prefilter.may_contain(x))return s.end();
+    return s.find_hashed(x,hash);
+  }
+
+private:
+  set_type                         s;
+  string_prefilter<allocator_type> prefilter;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,150 @@
+/* PoC of a static function (retrieval structure) of small values based
+ * on a keyless HD(C) minimal perfect hash function.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_STATIC_FUNCTION_HPP
+#define HD_STATIC_FUNCTION_HPP
+
+#include <boost/config.hpp>
+#include <boost/container_hash/hash.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include "hd_perfect_hash.hpp"
+#include "mulxp_hash.hpp"
+#include "packed_array.hpp"
+
+namespace hd{
+
+struct value_out_of_range:std::runtime_error
+{
+  value_out_of_range():
+    std::runtime_error("value does not fit in the value bits"){}
+};
+
+/* Maps each construction key to a ValueBits-bit value without storing the
+ * keys: values are packed at the positions given by hd::perfect_hash, so
+ * lookup reads a displacement code and then the value. Keys not in the
+ * construction set are mapped to an arbitrary value unless
+ * FingerprintBits>0, in which case a fingerprint is stored alongside each
+ * value (in the same packed slot) and find(x) reports non-members except
+ * for a false positive rate of 2^-FingerprintBits.
+ *
+ * Construction takes a range of (key,value) pairs.
+ */
+
+template<
+  typename T,std::size_t ValueBits,std::size_t FingerprintBits=0,
+  typename Hash=boost::hash<T>,typename Pred=std::equal_to<T>,
+  typename Allocator=std::allocator<T>
+>
+class static_function
+{
+  static_assert(ValueBits>0&&ValueBits+FingerprintBits<=64);
+
+  using perfect_hash_type=perfect_hash<T,Hash,Pred,Allocator>;
+  using slot_array=packed_array<
+    typename std::allocator_traits<Allocator>::
+      template rebind_alloc<std::uint64_t>>;
+
+public:
+  static constexpr std::size_t default_lambda=perfect_hash_type::default_lambda;
+  static constexpr std::size_t value_bits=ValueBits;
+  static constexpr std::size_t fingerprint_bits=FingerprintBits;
+  using key_type=T;
+  using mapped_type=std::uint64_t;
+  using hasher=Hash;
+  using key_equal=Pred;
+  using allocator_type=Allocator;
+
+  template<typename FwdIterator>
+  static_function(
+    FwdIterator first,FwdIterator last,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    ph{key_iterator(first),key_iterator(last),lambda,al},
+    slots(ph.size(),value_bits+fingerprint_bits,al)
+  {
+    for(auto it=first;it!=last;++it){
+      mapped_type v=it->second;
+      if(value_bits<64&&(v>>(value_bits%64)))throw value_out_of_range{};
+      auto hash=ph.hash_function()(it->first);
+      if constexpr(fingerprint_bits>0)v|=fingerprint(hash)<<value_bits;
+      slots.set(ph.position(hash),v);
+    }
+  }
+
+  allocator_type get_allocator()const{return ph.get_allocator();}
+  hasher         hash_function()const{return ph.hash_function();}
+
+  std::size_t size()const{return ph.size();}
+
+  /* memory used, in bits */
+
+  std::size_t size_in_bits()const
+  {
+    return ph.size_in_bits()+slots.capacity_in_bits();
+  }
+
+  /* undefined value for non-members, 0 if empty */
+
+  template<typename Key>
+  BOOST_FORCEINLINE mapped_type operator()(const Key& x)const
+  {
+    if(BOOST_UNLIKELY(!size()))return 0;
+    return slots.get(ph(x))&value_mask;
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE std::optional<mapped_type> find(const Key& x)const
+    requires (fingerprint_bits>0)
+  {
+    auto hash=ph.hash_function()(x);
+    if(!size())return std::nullopt;
+    auto slot=slots.get(ph.position(hash));
+    if((slot>>value_bits)!=fingerprint(hash))return std::nullopt;
+    return slot&value_mask;
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE bool contains(const Key& x)const
+    requires (fingerprint_bits>0)
+  {
+    return find(x).has_value();
+  }
+
+private:
+  static constexpr mapped_type value_mask=
+    value_bits>=64?~mapped_type(0):(mapped_type(1)<<value_bits)-1;
+
+  struct key_of
+  {
+    template<typename Pair>
+    const auto& operator()(const Pair& x)const{return x.first;}
+  };
+
+  template<typename FwdIterator>
+  static auto key_iterator(FwdIterator it)
+  {
+    return boost::make_transform_iterator(it,key_of{});
+  }
+
+  static std::uint64_t fingerprint(std::size_t hash)
+  {
+    return mulx(hash,0x9e3779b97f4a7c15ull)>>(64-fingerprint_bits);
+  }
+
+  perfect_hash_type ph;
+  slot_array        slots;
+};
+
+} /* namespace hd */
+
+#endif
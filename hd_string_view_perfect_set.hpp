@@ -0,0 +1,185 @@
+/* hd::perfect_set of std::string_view over keys held in a retained
+ * buffer: a memory-mapped key file or a columnar string array.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HD_STRING_VIEW_PERFECT_SET_HPP
+#define HD_STRING_VIEW_PERFECT_SET_HPP
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "hd_perfect_set.hpp"
+#include "mapped_file.hpp"
+
+namespace hd{
+
+/* Keys as lines of a file: every line is a key, empty ones included,
+ * with a final delimiter optional.
+ */
+
+struct key_file
+{
+  std::string path;
+  char        delimiter='\n';
+};
+
+/* Arrow-style string column: key i is data[offsets[i],offsets[i+1]), so
+ * offsets has size+1 entries. Offset is std::int32_t for Arrow's utf8
+ * and binary types and std::int64_t for their large variants; slices are
+ * passed by offsetting the offsets pointer. Null slots are not supported.
+ */
+
+template<typename Offset>
+struct string_column
+{
+  const Offset* offsets;
+  const char*   data;
+  std::size_t   size;
+};
+
+namespace string_view_perfect_set_detail{
+
+/* forward iterator over the delimited keys of a buffer */
+
+class line_iterator:public boost::iterator_facade<
+  line_iterator,std::string_view,boost::forward_traversal_tag,std::string_view>
+{
+public:
+  line_iterator()=default;
+  line_iterator(const char* p_,const char* last_,char delimiter_):
+    p{p_},last{last_},delimiter{delimiter_}{find_end();}
+
+private:
+  friend class boost::iterator_core_access;
+
+  std::string_view dereference()const
+  {
+    return {p,static_cast<std::size_t>(q-p)};
+  }
+
+  bool equal(const line_iterator& x)const{return p==x.p;}
+
+  void increment()
+  {
+    p=q==last?last:q+1;
+    find_end();
+  }
+
+  void find_end()
+  {
+    q=p==last?last:
+      static_cast<const char*>(
+        std::memchr(p,delimiter,static_cast<std::size_t>(last-p)));
+    if(!q)q=last;
+  }
+
+  const char *p=nullptr,*q=nullptr,*last=nullptr;
+  char        delimiter='\n';
+};
+
+template<typename Offset>
+struct column_key
+{
+  std::string_view operator()(std::size_t i)const
+  {
+    return {
+      c.data+c.offsets[i],
+      static_cast<std::size_t>(c.offsets[i+1]-c.offsets[i])};
+  }
+
+  string_column<Offset> c;
+};
+
+/* holds the buffer so that it is alive before the set is built from it */
+
+struct backing_holder
+{
+  std::shared_ptr<const void> owner;
+};
+
+} /* namespace string_view_perfect_set_detail */
+
+/* Construction takes no copy of the keys and allocates nothing per key:
+ * elements are std::string_views into the buffer, which the set keeps
+ * alive, shared among its copies, for as long as any of them exists. A
+ * key file is mapped (see mapped_file) and each line hashed in place. A
+ * column's buffers remain owned by the caller, who passes a keep-alive
+ * owner (e.g. the std::shared_ptr of the Arrow array) or none if it
+ * guarantees their lifetime otherwise. Lookup takes anything convertible
+ * to std::string_view.
+ */
+
+template<
+  typename Hash=boost::hash<std::string_view>,
+  typename Pred=std::equal_to<std::string_view>,
+  typename Allocator=std::allocator<std::string_view>
+>
+class string_view_perfect_set:
+  private string_view_perfect_set_detail::backing_holder,
+  public perfect_set<std::string_view,Hash,Pred,Allocator>
+{
+  using holder=string_view_perfect_set_detail::backing_holder;
+  using super=perfect_set<std::string_view,Hash,Pred,Allocator>;
+
+public:
+  using typename super::allocator_type;
+  using super::default_lambda;
+
+  explicit string_view_perfect_set(
+    const key_file& f,std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    string_view_perfect_set{
+      std::make_shared<const mapped_file>(f.path),f.delimiter,lambda,al}
+  {}
+
+  template<typename Offset>
+  string_view_perfect_set(
+    const string_column<Offset>& c,std::shared_ptr<const void> owner,
+    std::size_t lambda=default_lambda,
+    const allocator_type& al=allocator_type()):
+    holder{std::move(owner)},
+    super{column_begin(c),column_begin(c)+c.size,lambda,al}
+  {}
+
+  /* the file or column buffers, if held */
+
+  const std::shared_ptr<const void>& backing()const{return this->owner;}
+
+private:
+  using line_iterator=string_view_perfect_set_detail::line_iterator;
+
+  string_view_perfect_set(
+    std::shared_ptr<const mapped_file> file,char delimiter,
+    std::size_t lambda,const allocator_type& al):
+    holder{file},
+    super{
+      line_iterator{file->data(),file->data()+file->size(),delimiter},
+      line_iterator{
+        file->data()+file->size(),file->data()+file->size(),delimiter},
+      lambda,al}
+  {}
+
+  template<typename Offset>
+  static auto column_begin(const string_column<Offset>& c)
+  {
+    return boost::make_transform_iterator(
+      boost::counting_iterator<std::size_t>(0),
+      string_view_perfect_set_detail::column_key<Offset>{c});
+  }
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,133 @@
+/* Per-slot lookup hit counters.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HIT_COUNTERS_HPP
+#define HIT_COUNTERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <boost/config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace hd{
+
+/* One 64-bit counter per slot of a container, incremented with relaxed
+ * atomic operations so that concurrent lookups need no further
+ * synchronization (though they contend on the cache lines of hot slots).
+ * snapshot and reset are not atomic with respect to the container as a
+ * whole: increments running concurrently are either seen or kept for the
+ * next snapshot, but never lost.
+ */
+
+class hit_counters
+{
+public:
+  using snapshot_type=std::vector<std::uint64_t>;
+
+  explicit hit_counters(std::size_t n=0):
+    n_{n},counters{new std::atomic<std::uint64_t>[n]()}{}
+
+  hit_counters(const hit_counters& x):hit_counters(x.n_)
+  {
+    for(std::size_t i=0;i<n_;++i)counters[i]=x[i];
+  }
+
+  hit_counters(hit_counters&& x)noexcept:
+    n_{std::exchange(x.n_,0)},counters{std::move(x.counters)}{}
+
+  hit_counters& operator=(const hit_counters& x)
+  {
+    if(this!=&x)*this=hit_counters(x);
+    return *this;
+  }
+
+  hit_counters& operator=(hit_counters&& x)noexcept
+  {
+    n_=std::exchange(x.n_,0);
+    counters=std::move(x.counters);
+    return *this;
+  }
+
+  std::size_t size()const{return n_;}
+
+  BOOST_FORCEINLINE void increment(std::size_t i)
+  {
+    counters[i].fetch_add(1,std::memory_order_relaxed);
+  }
+
+  std::uint64_t operator[](std::size_t i)const
+  {
+    return counters[i].load(std::memory_order_relaxed);
+  }
+
+  /* counts by slot, zeroed afterwards if reset */
+
+  snapshot_type snapshot(bool reset=false)
+  {
+    snapshot_type res(n_);
+    for(std::size_t i=0;i<n_;++i){
+      res[i]=reset?
+        counters[i].exchange(0,std::memory_order_relaxed):
+        counters[i].load(std::memory_order_relaxed);
+    }
+    return res;
+  }
+
+  void reset()
+  {
+    for(std::size_t i=0;i<n_;++i){
+      counters[i].store(0,std::memory_order_relaxed);
+    }
+  }
+
+  /* up to k (slot,count) pairs with the highest nonzero counts, in
+   * decreasing count order (ties by slot)
+   */
+
+  std::vector<std::pair<std::size_t,std::uint64_t>>
+  top(std::size_t k,bool reset=false)
+  {
+    return top(snapshot(reset),k);
+  }
+
+  static std::vector<std::pair<std::size_t,std::uint64_t>>
+  top(const snapshot_type& s,std::size_t k)
+  {
+    std::vector<std::pair<std::size_t,std::uint64_t>> res;
+    for(std::size_t i=0;i<s.size();++i)if(s[i])res.push_back({i,s[i]});
+    auto more_hits=[](const auto& x,const auto& y){
+      return x.second>y.second||(x.second==y.second&&x.first<y.first);
+    };
+    k=(std::min)(k,res.size());
+    std::partial_sort(res.begin(),res.begin()+k,res.end(),more_hits);
+    res.resize(k);
+    return res;
+  }
+
+private:
+  std::size_t                                  n_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> counters;
+};
+
+/* Stand-in for hit_counters when counting is disabled: increments compile
+ * to nothing and, as a [[no_unique_address]] member, it takes no space.
+ */
+
+struct no_hit_counters
+{
+  explicit no_hit_counters(std::size_t=0){}
+  void increment(std::size_t){}
+};
+
+} /* namespace hd */
+
+#endif
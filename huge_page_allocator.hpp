@@ -0,0 +1,143 @@
+/* Allocator placing perfect set tables in huge pages.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef HUGE_PAGE_ALLOCATOR_HPP
+#define HUGE_PAGE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace hd{
+
+/* Requests of at least huge_page_size bytes are served with MAP_HUGETLB
+ * pages and, if none are reserved in the system, with regular pages aligned
+ * to huge_page_size and madvise'd for transparent huge pages. Smaller
+ * requests get their own regular mapping. Memory is prefaulted on
+ * allocation so that the first lookups after construction do not incur page
+ * faults, and if Lock is true it is also mlock'ed (on a best-effort basis,
+ * as RLIMIT_MEMLOCK may prevent it). Non-Linux platforms fall back to
+ * ::operator new.
+ */
+
+template<typename T,bool Lock=false>
+struct huge_page_allocator
+{
+  using value_type=T;
+
+  template<typename U>
+  struct rebind{using other=huge_page_allocator<U,Lock>;};
+
+  static constexpr std::size_t huge_page_size=std::size_t(2)<<20;
+
+  huge_page_allocator()=default;
+  template<typename U>
+  huge_page_allocator(const huge_page_allocator<U,Lock>&)noexcept{}
+
+  T* allocate(std::size_t n)
+  {
+    if(n>(std::numeric_limits<std::size_t>::max)()/sizeof(T)){
+      throw std::bad_array_new_length{};
+    }
+#if defined(__linux__)
+    auto bytes=n*sizeof(T);
+    auto len=mapping_size(bytes);
+    void* p=MAP_FAILED;
+    if(bytes>=huge_page_size){
+      p=::mmap(
+        nullptr,len,PROT_READ|PROT_WRITE,
+        MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+      if(p==MAP_FAILED)p=map_transparent(len);
+    }
+    else{
+      p=::mmap(
+        nullptr,len,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    }
+    if(p==MAP_FAILED)throw std::bad_alloc{};
+    prefault(p,len);
+    if(Lock)::mlock(p,len);
+    return static_cast<T*>(p);
+#else
+    return static_cast<T*>(::operator new(n*sizeof(T)));
+#endif
+  }
+
+  void deallocate(T* p,std::size_t n)noexcept
+  {
+#if defined(__linux__)
+    ::munmap(p,mapping_size(n*sizeof(T)));
+#else
+    ::operator delete(p);
+#endif
+  }
+
+  friend bool operator==(const huge_page_allocator&,const huge_page_allocator&)
+  {
+    return true;
+  }
+
+  friend bool operator!=(const huge_page_allocator&,const huge_page_allocator&)
+  {
+    return false;
+  }
+
+private:
+#if defined(__linux__)
+  static std::size_t page_size()
+  {
+    static const std::size_t s=static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return s;
+  }
+
+  static std::size_t mapping_size(std::size_t bytes)
+  {
+    auto granularity=bytes>=huge_page_size?huge_page_size:page_size();
+    if(!bytes)bytes=1;
+    return (bytes+granularity-1)/granularity*granularity;
+  }
+
+  static void* map_transparent(std::size_t len)
+  {
+    /* overallocate and trim so that the mapping is huge page aligned */
+
+    auto p=::mmap(
+      nullptr,len+huge_page_size,PROT_READ|PROT_WRITE,
+      MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    if(p==MAP_FAILED)return p;
+    auto first=reinterpret_cast<std::uintptr_t>(p);
+    auto aligned=(first+huge_page_size-1)&~(huge_page_size-1);
+    auto last=first+len+huge_page_size;
+    if(aligned!=first)::munmap(p,aligned-first);
+    if(last!=aligned+len)::munmap(
+      reinterpret_cast<void*>(aligned+len),last-(aligned+len));
+    p=reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+    ::madvise(p,len,MADV_HUGEPAGE);
+#endif
+    return p;
+  }
+
+  static void prefault(void* p,std::size_t len)
+  {
+    /* write rather than read, as reads would map the shared zero page */
+
+    auto first=static_cast<volatile unsigned char*>(p);
+    for(std::size_t i=0;i<len;i+=page_size())first[i]=0;
+  }
+#endif
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,168 @@
+/* Construction time, heap allocations and lookup time of a perfect set of
+ * strings built from a key file or a string column: read into
+ * std::strings for hd::perfect_set vs. viewed in place by
+ * hd::string_view_perfect_set.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "allocation_counter.hpp"
+#include "hd_string_view_perfect_set.hpp"
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+using hasher=hd::mulxp3_string_hash;
+
+template<typename F>
+void test(
+  const char* name,const std::vector<std::string>& queries,std::size_t n,
+  F f)
+{
+  auto base=allocated;
+  auto base_allocations=num_allocations;
+  peak_allocated=allocated;
+  auto t=std::chrono::high_resolution_clock::now();
+  auto c=f();
+  auto build=std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now()-t).count();
+  auto allocations=num_allocations-base_allocations;
+  auto peak=peak_allocated-base;
+
+  if(find_all{}(queries.begin(),queries.end(),c)!=queries.size()){
+    std::cerr<<"element not found"<<std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::cout
+    <<n<<";"<<name<<";"<<build*1E9/n<<";"<<allocations<<";"
+    <<static_cast<double>(peak)/n<<";"
+    <<measure([&]{
+        return find_all{}(queries.begin(),queries.end(),c);
+      })*1E9/queries.size()<<";"
+    <<std::endl;
+}
+
+int main(int argc,char* argv[])
+{
+  /* ingest_build [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):1'000'000;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::string                                path="ingest_build.keys";
+
+  std::cout
+    <<"n;method;build (ns/elem);allocations;peak heap (bytes/elem);"
+      "lookup (ns);"<<std::endl;
+  for(std::size_t n=10'000;n<=max_n;n*=10){
+    std::vector<std::string> keys;
+    {
+      std::ofstream os(path,std::ios::binary|std::ios::trunc);
+      for(std::size_t i=0;i<n;++i){
+        keys.push_back(
+          "key-"+std::to_string(dist(gen))+"-"+std::to_string(i));
+        os<<keys.back()<<"\n";
+      }
+    }
+    std::vector<std::string> queries;
+    for(std::size_t i=0;i<1'000'000;++i)queries.push_back(keys[dist(gen)%n]);
+
+    /* the column lives in the heap before construction, as if received */
+
+    auto data=std::make_shared<std::string>();
+    auto offsets=std::make_shared<std::vector<std::int64_t>>(1,0);
+    for(const auto& x:keys){
+      *data+=x;
+      offsets->push_back(static_cast<std::int64_t>(data->size()));
+    }
+    keys=std::vector<std::string>{};
+
+    test("file, std::string",queries,n,[&]{
+      std::vector<std::string> v;
+      std::ifstream            is(path,std::ios::binary);
+      for(std::string line;std::getline(is,line);)v.push_back(line);
+      return hd::perfect_set<std::string,hasher>(v.begin(),v.end());
+    });
+    test("file, mapped",queries,n,[&]{
+      return hd::string_view_perfect_set<hasher>(hd::key_file{path});
+    });
+    test("column, std::string",queries,n,[&]{
+      std::vector<std::string> v;
+      for(std::size_t i=0;i<n;++i){
+        v.emplace_back(
+          data->data()+(*offsets)[i],
+          static_cast<std::size_t>((*offsets)[i+1]-(*offsets)[i]));
+      }
+      return hd::perfect_set<std::string,hasher>(v.begin(),v.end());
+    });
+    test("column, in place",queries,n,[&]{
+      return hd::string_view_perfect_set<hasher>(
+        hd::string_column<std::int64_t>{offsets->data(),data->data(),n},
+        data);
+    });
+  }
+  std::remove(path.c_str());
+}
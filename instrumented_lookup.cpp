@@ -0,0 +1,149 @@
+/* Overhead of lookup instrumentation on hd::perfect_set and
+ * fks::perfect_set, and a sample of its text exposition.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "fks_perfect_set.hpp"
+#include "lookup_instrumentation.hpp"
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+using value_type=std::size_t;
+using sampled=hd::lookup_instrumentation<>;
+using fully_sampled=hd::lookup_instrumentation<1>;
+
+template<typename Instrumentation>
+using hd_set=hd::perfect_set<
+  value_type,hd::mbs_hash,std::equal_to<value_type>,
+  std::allocator<value_type>,
+  hd::pow2_lower_size_policy,hd::pow2_upper_size_policy,false,
+  Instrumentation>;
+
+template<typename Instrumentation>
+using fks_set=fks::perfect_set<
+  value_type,hd::m_hash,std::equal_to<value_type>,
+  std::allocator<value_type>,fks::pow2_upper_size_policy,Instrumentation>;
+
+template<template<typename> class Set,typename Data>
+void test(const char* name,const Data& data,const Data& input)
+{
+  Set<hd::no_instrumentation> s0(data.begin(),data.end());
+  Set<sampled>                s1(data.begin(),data.end());
+  Set<fully_sampled>          s2(data.begin(),data.end());
+  auto first=input.begin(),last=input.end();
+  auto n=input.size();
+
+  std::cout
+    <<name<<";"<<data.size()<<";"
+    <<measure([&]{return find_all{}(first,last,s0);})*1E9/n<<";"
+    <<measure([&]{return find_all{}(first,last,s1);})*1E9/n<<";"
+    <<measure([&]{return find_all{}(first,last,s2);})*1E9/n<<";"
+    <<std::endl;
+}
+
+int main(int argc,char* argv[])
+{
+  /* instrumented_lookup [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):1'000'000;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  std::cout
+    <<"container;n;plain (ns);sampled 1/"<<sampled::sample_rate
+    <<" (ns);all sampled (ns);"<<std::endl;
+  for(std::size_t n=1'000;n<=max_n;n*=10){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    auto input=data;
+    for(std::size_t i=0;i<input.size();i+=2)input[i]+=1; /* 50/50 */
+    std::shuffle(input.begin(),input.end(),gen);
+
+    test<hd_set>("hd::perfect_set",data,input);
+    test<fks_set>("fks::perfect_set",data,input);
+  }
+
+  /* exposition after concurrent 50/50 lookups */
+
+  data.resize((std::min)(max_n,std::size_t(100'000)));
+  auto input=data;
+  for(std::size_t i=0;i<input.size();i+=2)input[i]+=1;
+  hd_set<sampled>  hs(data.begin(),data.end());
+  fks_set<sampled> fs(data.begin(),data.end());
+  std::vector<std::thread> threads;
+  for(int t=0;t<4;++t){
+    threads.emplace_back([&]{
+      for(int i=0;i<10;++i){
+        find_all{}(input.begin(),input.end(),hs);
+        find_all{}(input.begin(),input.end(),fs);
+      }
+    });
+  }
+  for(auto& t:threads)t.join();
+  std::cout<<std::endl;
+  hs.instrumentation().dump(std::cout,"hd_perfect_set");
+  fs.instrumentation().dump(std::cout,"fks_perfect_set");
+}
@@ -0,0 +1,188 @@
+/* Measuring lookup performance of perfect sets at DRAM-resident sizes.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+#include <boost/mp11/utility.hpp>
+#include <boost/unordered/unordered_flat_set.hpp>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <random>
+#include <string>
+#include "hd_perfect_set.hpp"
+#include "hd_bucketed_perfect_set.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+/* Lookups are done on num_queries random elements (or non-elements) so
+ * that every access is essentially a cache miss for large n.
+ */
+
+static constexpr std::size_t num_queries=1'000'000;
+
+template<typename Containers,typename Data,typename Input>
+void test(
+  const char* title,std::initializer_list<const char*> names,
+  const Data& data,const Input& input,std::size_t max_n)
+{
+  std::cout<<title<<":"<<std::endl;
+  for(const auto& name:names)std::cout<<name<<";";
+  std::cout<<std::endl;
+
+  for(std::size_t n=1'000'000;n<=(std::min)(max_n,data.size());n*=2){
+    auto         first=data.begin(),last=data.begin()+n;
+    Input        queries;
+    std::mt19937 gen(n);
+    std::uniform_int_distribution<std::size_t> dist(0,n-1);
+    for(std::size_t i=0;i<num_queries;++i)queries.push_back(input[dist(gen)]);
+    auto qfirst=queries.begin(),qlast=queries.end();
+
+    std::cout<<n<<";";
+
+    boost::mp11::mp_for_each<
+      boost::mp11::mp_transform<boost::mp11::mp_identity,Containers>
+    >([&](auto t_){
+      using Container=typename decltype(t_)::type;
+      Container s(first,last);
+      std::cout
+        <<measure([&]{return find_all{}(qfirst,qlast,s);})*1E9/num_queries
+        <<";";
+    });
+    std::cout<<std::endl;
+  }
+}
+
+static std::string make_string(std::size_t x)
+{
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"pfx_%zu_sfx",x);
+  return buffer;
+}
+
+int main(int argc,char* argv[])
+{
+  /* large_lookup [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):32'000'000;
+  {
+    using value_type=std::size_t;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    for(std::size_t i=0;i<max_n;++i)data.push_back(dist(gen));
+
+    using containers=boost::mp11::mp_list<
+      boost::unordered_flat_set<value_type>,
+      hd::perfect_set<value_type,hd::mbs_hash>,
+      hd::bucketed_perfect_set<value_type,hd::mbs_hash>
+    >;
+    auto names={
+      "boost::unordered_flat_set",
+      "hd::perfect_set mbs",
+      "hd::bucketed_perfect_set mbs",
+    };
+
+    test<containers>("Successful find, integers",names,data,data,max_n);
+
+    auto input=data;
+    for(auto& x:input)x+=1;
+
+    test<containers>("Unsuccessful find, integers",names,data,input,max_n);
+  }
+  {
+    using value_type=std::string;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    max_n/=4;
+    for(std::size_t i=0;i<max_n;++i)data.push_back(make_string(dist(gen)));
+
+    using containers=boost::mp11::mp_list<
+      boost::unordered_flat_set<value_type>,
+      hd::perfect_set<value_type,hd::mulxp3_string_hash>,
+      hd::bucketed_perfect_set<value_type,hd::mulxp3_string_hash>
+    >;
+    auto names={
+      "boost::unordered_flat_set",
+      "hd::perfect_set",
+      "hd::bucketed_perfect_set",
+    };
+
+    test<containers>("Successful find, strings",names,data,data,max_n);
+
+    auto input=data;
+    for(auto& x:input)x[x.size()/2]='*';
+
+    test<containers>("Unsuccessful find, strings",names,data,input,max_n);
+  }
+}
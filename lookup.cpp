@@ -64,7 +64,11 @@ void resume_timing()
 #include <random>
 #include <string>
 #include "hd_perfect_set.hpp"
+#include "hd_bucketed_perfect_set.hpp"
+#include "hd_prefiltered_set.hpp"
 #include "fks_perfect_set.hpp"
+#include "huge_page_allocator.hpp"
+#include "counting_allocator.hpp"
 
 struct splitmix64_urng:boost::detail::splitmix64
 {
@@ -128,6 +132,34 @@ void test(
     std::cout<<std::endl;
   }
 }
+
+template<typename Containers,typename Data>
+void test_memory(
+  const char* title,std::initializer_list<const char*> names,
+  const Data& data)
+{
+  std::cout<<title<<" (bytes/element):"<<std::endl;
+  for(const auto& name:names)std::cout<<name<<";";
+  std::cout<<std::endl;
+
+  unsigned int n0=10,dn=10;
+  double       fdn=1.1;
+  for(unsigned int n=n0;n<=data.size();n+=dn,dn=(unsigned int)(dn*fdn)){
+    auto first=data.begin(),last=data.begin()+n;
+
+    std::cout<<n<<";";
+
+    boost::mp11::mp_for_each<
+      boost::mp11::mp_transform<boost::mp11::mp_identity,Containers>
+    >([&](auto t_){
+      using Container=typename decltype(t_)::type;
+      auto      bytes0=allocated_bytes;
+      Container s(first,last);
+      std::cout<<(double)(allocated_bytes-bytes0)/n<<";";
+    });
+    std::cout<<std::endl;
+  }
+}
   
 static std::string make_string(std::size_t x)
 {
@@ -158,13 +190,37 @@ int main()
       boost::unordered_set<value_type>,
       boost::unordered_flat_set<value_type>,
       hd::perfect_set<value_type,hd::mbs_hash>,
-      fks::perfect_set<value_type,hd::m_hash>
+      fks::perfect_set<value_type,hd::m_hash>,
+      hd::bucketed_perfect_set<value_type,hd::mbs_hash>,
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,
+        std::allocator<value_type>,
+        hd::fastrange_lower_size_policy,hd::fastrange_upper_size_policy>,
+      fks::perfect_set<
+        value_type,hd::m_hash,std::equal_to<value_type>,
+        std::allocator<value_type>,fks::fastrange_upper_size_policy>,
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,
+        hd::huge_page_allocator<value_type>>,
+      fks::perfect_set<
+        value_type,hd::m_hash,std::equal_to<value_type>,
+        hd::huge_page_allocator<value_type>>,
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,
+        std::allocator<value_type>,
+        hd::pow2_lower_size_policy,hd::pow2_upper_size_policy,true>
     >;
     auto names={
       "boost::unordered_set",
       "boost::unordered_flat_set",
       "hd::perfect_set mbs",
       "fks::perfect_set m",
+      "hd::bucketed_perfect_set mbs",
+      "hd::perfect_set mbs fastrange",
+      "fks::perfect_set m fastrange",
+      "hd::perfect_set mbs huge pages",
+      "fks::perfect_set m huge pages",
+      "hd::perfect_set mbs hit counting",
     };
 
     test<containers>("Successful find, integers",names,data,data);
@@ -177,6 +233,32 @@ int main()
     for(std::size_t i=1;i<input.size();i+=2)input[i]+=1;
 
     test<containers>("Unsuccessful find, integers",names,data,input);
+
+    using allocator_type=counting_allocator<value_type>;
+    using memory_containers=boost::mp11::mp_list<
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,allocator_type>,
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,allocator_type,
+        hd::fastrange_lower_size_policy,hd::fastrange_upper_size_policy>,
+      hd::perfect_set<
+        value_type,hd::mbs_hash,std::equal_to<value_type>,allocator_type,
+        hd::fastmod_lower_size_policy,hd::fastmod_upper_size_policy>,
+      fks::perfect_set<
+        value_type,hd::m_hash,std::equal_to<value_type>,allocator_type>,
+      fks::perfect_set<
+        value_type,hd::m_hash,std::equal_to<value_type>,allocator_type,
+        fks::fastrange_upper_size_policy>
+    >;
+    auto memory_names={
+      "hd::perfect_set mbs",
+      "hd::perfect_set mbs fastrange",
+      "hd::perfect_set mbs fastmod",
+      "fks::perfect_set m",
+      "fks::perfect_set m fastrange",
+    };
+
+    test_memory<memory_containers>("Memory, integers",memory_names,data);
   }
   {
     using value_type=std::string;
@@ -191,13 +273,23 @@ int main()
       boost::unordered_set<value_type>,
       boost::unordered_flat_set<value_type>,
       hd::perfect_set<value_type,hd::mulxp3_string_hash>,
-      fks::perfect_set<value_type,hd::mulxp3_string_hash>
+      fks::perfect_set<value_type,hd::mulxp3_string_hash>,
+      hd::bucketed_perfect_set<value_type,hd::mulxp3_string_hash>,
+      hd::perfect_set<
+        value_type,hd::mulxp3_string_hash,std::equal_to<value_type>,
+        std::allocator<value_type>,
+        hd::fastrange_lower_size_policy,hd::fastrange_upper_size_policy>,
+      hd::prefiltered_set<
+        hd::perfect_set<value_type,hd::mulxp3_string_hash>>
     >;
     auto names={
       "boost::unordered_set",
       "boost::unordered_flat_set",
       "hd::perfect_set",
       "fks::perfect_set",
+      "hd::bucketed_perfect_set",
+      "hd::perfect_set fastrange",
+      "hd::perfect_set prefiltered",
     };
 
     test<containers>("Successful find, strings",names,data,data);
@@ -0,0 +1,307 @@
+/* Lookup counters and sampled latency histograms for perfect sets.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef LOOKUP_INSTRUMENTATION_HPP
+#define LOOKUP_INSTRUMENTATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <boost/config.hpp>
+#include <boost/core/bit.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#if defined(_MSC_VER)&&(defined(_M_X64)||defined(_M_IX86))
+#include <intrin.h>
+#define LOOKUP_INSTRUMENTATION_RDTSC
+#elif defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#define LOOKUP_INSTRUMENTATION_RDTSC
+#endif
+
+namespace hd{
+
+enum class lookup_outcome
+{
+  hit=0,
+  miss=1,     /* key compared and found different */
+  rejected=2  /* miss detected without a key comparison */
+};
+
+/* Instrumentation policy doing nothing: the default for the perfect sets,
+ * whose lookup code is then the same as without instrumentation.
+ */
+
+struct no_instrumentation
+{
+  struct token{};
+
+  token start()const{return {};}
+  void  finish(token,lookup_outcome)const{}
+  void  count(lookup_outcome)const{}
+};
+
+/* Current value of the time stamp counter (or of the steady clock, in
+ * nanoseconds, where there's none).
+ */
+
+BOOST_FORCEINLINE std::uint64_t cycle_count()
+{
+#if defined(LOOKUP_INSTRUMENTATION_RDTSC)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/* Totals as of some point in time. histogram[i] is the number of sampled
+ * lookups that took more than 2^(i-1) and at most 2^i cycles, except for
+ * the last bucket, which also holds everything above.
+ */
+
+struct lookup_statistics
+{
+  static constexpr std::size_t num_buckets=32;
+
+  std::uint64_t lookups()const{return hits+misses;}
+
+  /* dumps in Prometheus text exposition format, metric names prefixed by
+   * name
+   */
+
+  void dump(std::ostream& os,const std::string& name)const
+  {
+    os<<"# TYPE "<<name<<"_lookups_total counter\n";
+    os<<name<<"_lookups_total{outcome=\"hit\"} "<<hits<<"\n";
+    os<<name<<"_lookups_total{outcome=\"miss\"} "<<misses-rejections<<"\n";
+    os<<name<<"_lookups_total{outcome=\"rejected\"} "<<rejections<<"\n";
+    os<<"# TYPE "<<name<<"_lookup_cycles histogram\n";
+    std::uint64_t cumulative=0;
+    for(std::size_t i=0;i<num_buckets-1;++i){
+      cumulative+=histogram[i];
+      os<<name<<"_lookup_cycles_bucket{le=\""<<(std::uint64_t(1)<<i)<<"\"} "
+        <<cumulative<<"\n";
+    }
+    os<<name<<"_lookup_cycles_bucket{le=\"+Inf\"} "<<samples<<"\n";
+    os<<name<<"_lookup_cycles_sum "<<sampled_cycles<<"\n";
+    os<<name<<"_lookup_cycles_count "<<samples<<"\n";
+  }
+
+  bool dump(const char* path,const std::string& name)const
+  {
+    std::ofstream os(path);
+    dump(os,name);
+    return static_cast<bool>(os);
+  }
+
+  std::uint64_t hits=0,
+                misses=0,     /* rejections included */
+                rejections=0,
+                samples=0,
+                sampled_cycles=0,
+                histogram[num_buckets]={};
+};
+
+/* Counts lookup outcomes and, for one in SampleRate lookups of each
+ * thread (whatever the set), their duration in cycles, taken with rdtsc
+ * where available. Each thread updates its own cache-line-aligned
+ * shard with plain (non-RMW) relaxed stores, so the hot path has no
+ * locked instructions nor false sharing; threads are assigned shards in
+ * order of first use, and from the MaxShards-th on share them, in which
+ * case concurrent updates to a shared shard may occasionally be lost.
+ * statistics() adds up all shards and can be called at any time.
+ *
+ * Only individual lookups (find, find_hashed) are timed; batched lookups
+ * are counted but not sampled.
+ */
+
+template<std::size_t SampleRate=1024,std::size_t MaxShards=64>
+class lookup_instrumentation
+{
+  static_assert(SampleRate>0&&MaxShards>0);
+
+public:
+  static constexpr std::size_t sample_rate=SampleRate;
+  static constexpr std::size_t max_shards=MaxShards;
+
+  using token=std::uint64_t; /* start cycle count, 0 if not sampled */
+
+  lookup_instrumentation():shards{new shard[max_shards]}{}
+
+  /* Copies start off with zero counts, while moves take the counts over.
+   * A moved-from object counts into a shared sink and reports zero
+   * statistics until assigned to.
+   */
+
+  lookup_instrumentation(const lookup_instrumentation&):
+    lookup_instrumentation(){}
+
+  lookup_instrumentation(lookup_instrumentation&& x)noexcept:
+    shards{std::exchange(x.shards,sink())}{}
+
+  ~lookup_instrumentation(){release();}
+
+  lookup_instrumentation& operator=(const lookup_instrumentation& x)
+  {
+    if(this!=&x){
+      if(shards==sink())shards=new shard[max_shards];
+      else              reset();
+    }
+    return *this;
+  }
+
+  lookup_instrumentation& operator=(lookup_instrumentation&& x)noexcept
+  {
+    if(this!=&x){
+      release();
+      shards=std::exchange(x.shards,sink());
+    }
+    return *this;
+  }
+
+  BOOST_FORCEINLINE token start()const
+  {
+    static thread_local std::size_t countdown=0;
+    if(BOOST_LIKELY(countdown)){
+      --countdown;
+      return 0;
+    }
+    countdown=sample_rate-1;
+    return cycle_count();
+  }
+
+  BOOST_FORCEINLINE void finish(token t,lookup_outcome o)const
+  {
+    if(BOOST_UNLIKELY(t!=0))sample(cycle_count()-t);
+    count(o);
+  }
+
+  /* indexed by outcome rather than switched on, so as not to add
+   * branches to the lookup
+   */
+
+  BOOST_FORCEINLINE void count(lookup_outcome o)const
+  {
+    increment(this_thread_shard().outcomes[static_cast<std::size_t>(o)]);
+  }
+
+  lookup_statistics statistics()const
+  {
+    lookup_statistics res;
+    if(shards==sink())return res;
+    for(std::size_t i=0;i<max_shards;++i){
+      const auto& s=shards[i];
+      res.hits+=load(s.outcomes[0]);
+      res.misses+=load(s.outcomes[1])+load(s.outcomes[2]);
+      res.rejections+=load(s.outcomes[2]);
+      res.samples+=load(s.samples);
+      res.sampled_cycles+=load(s.sampled_cycles);
+      for(std::size_t j=0;j<lookup_statistics::num_buckets;++j){
+        res.histogram[j]+=load(s.histogram[j]);
+      }
+    }
+    return res;
+  }
+
+  /* not synchronized with lookups in progress */
+
+  void reset()const
+  {
+    if(shards==sink())return;
+    for(std::size_t i=0;i<max_shards;++i){
+      auto& s=shards[i];
+      for(auto& c:s.outcomes)c=0;
+      s.samples=s.sampled_cycles=0;
+      for(auto& c:s.histogram)c=0;
+    }
+  }
+
+  void dump(std::ostream& os,const std::string& name)const
+  {
+    statistics().dump(os,name);
+  }
+
+  bool dump(const char* path,const std::string& name)const
+  {
+    return statistics().dump(path,name);
+  }
+
+private:
+  using counter=std::atomic<std::uint64_t>;
+
+  struct alignas(64) shard
+  {
+    counter outcomes[3]{},samples{0},sampled_cycles{0},
+            histogram[lookup_statistics::num_buckets]{};
+  };
+
+  static std::uint64_t load(const counter& c)
+  {
+    return c.load(std::memory_order_relaxed);
+  }
+
+  static BOOST_FORCEINLINE void increment(counter& c,std::uint64_t n=1)
+  {
+    c.store(c.load(std::memory_order_relaxed)+n,std::memory_order_relaxed);
+  }
+
+  /* constant-initialized so that access needs no TLS guard */
+
+  static BOOST_FORCEINLINE std::size_t this_thread_index()
+  {
+    static thread_local std::size_t index=max_shards;
+    if(BOOST_UNLIKELY(index==max_shards))index=new_thread_index();
+    return index;
+  }
+
+  static BOOST_NOINLINE std::size_t new_thread_index()
+  {
+    static std::atomic<std::size_t> next_index{0};
+    return next_index.fetch_add(1,std::memory_order_relaxed)%max_shards;
+  }
+
+  static shard* sink()
+  {
+    static shard s[max_shards];
+    return s;
+  }
+
+  void release()
+  {
+    if(shards!=sink())delete[] shards;
+  }
+
+  BOOST_FORCEINLINE shard& this_thread_shard()const
+  {
+    return shards[this_thread_index()];
+  }
+
+  BOOST_NOINLINE void sample(std::uint64_t cycles)const
+  {
+    auto& s=this_thread_shard();
+    auto  bucket=(std::min)(
+      static_cast<std::size_t>(boost::core::bit_width(cycles?cycles-1:0)),
+      lookup_statistics::num_buckets-1);
+    increment(s.samples);
+    increment(s.sampled_cycles,cycles);
+    increment(s.histogram[bucket]);
+  }
+
+  shard* shards;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,114 @@
+/* Read-only view of a whole file, memory-mapped where supported.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+namespace hd{
+
+/* The file is mapped on Linux and read into memory otherwise: either way,
+ * data() is aligned to 8 bytes at least and stays valid (and constant, as
+ * long as the file is not modified) for the lifetime of the object.
+ */
+
+class mapped_file
+{
+public:
+  explicit mapped_file(const std::string& path):
+    size_{static_cast<std::size_t>(std::filesystem::file_size(path))}
+  {
+    if(!size_)return;
+#if defined(__linux__)
+    int fd=::open(path.c_str(),O_RDONLY);
+    if(fd<0)throw std::runtime_error("can't open "+path);
+    map=::mmap(nullptr,size_,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);
+    if(map==MAP_FAILED)throw std::runtime_error("can't map "+path);
+#else
+    storage.resize((size_+7)/8);
+    std::ifstream is(path,std::ios::binary);
+    if(!is.read(
+         reinterpret_cast<char*>(storage.data()),
+         static_cast<std::streamsize>(size_))){
+      throw std::runtime_error("can't read "+path);
+    }
+#endif
+  }
+
+  mapped_file(mapped_file&& x)noexcept:
+    size_{std::exchange(x.size_,0)},
+#if defined(__linux__)
+    map{std::exchange(x.map,nullptr)}
+#else
+    storage{std::move(x.storage)}
+#endif
+  {}
+
+  mapped_file& operator=(mapped_file&& x)noexcept
+  {
+    if(this!=&x){
+      release();
+      size_=std::exchange(x.size_,0);
+#if defined(__linux__)
+      map=std::exchange(x.map,nullptr);
+#else
+      storage=std::move(x.storage);
+#endif
+    }
+    return *this;
+  }
+
+  ~mapped_file(){release();}
+
+  const char* data()const
+  {
+#if defined(__linux__)
+    return static_cast<const char*>(map);
+#else
+    return reinterpret_cast<const char*>(storage.data());
+#endif
+  }
+
+  std::size_t size()const{return size_;}
+
+private:
+  void release()
+  {
+#if defined(__linux__)
+    if(map)::munmap(map,size_);
+    map=nullptr;
+#endif
+  }
+
+  std::size_t size_;
+#if defined(__linux__)
+  void*       map=nullptr;
+#else
+  std::vector<std::uint64_t> storage;
+#endif
+};
+
+} /* namespace hd */
+
+#endif
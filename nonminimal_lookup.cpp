@@ -0,0 +1,248 @@
+/* Comparing minimal and non-minimal hd perfect sets: construction time,
+ * memory, lookup time and branch mispredictions.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "hd_nonminimal_perfect_set.hpp"
+#include "counting_allocator.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+/* branch mispredictions of the calling thread, if perf events are available */
+
+struct branch_miss_counter
+{
+  branch_miss_counter()
+  {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.type=PERF_TYPE_HARDWARE;
+    attr.size=sizeof(attr);
+    attr.config=PERF_COUNT_HW_BRANCH_MISSES;
+    attr.disabled=1;
+    attr.exclude_kernel=1;
+    attr.exclude_hv=1;
+    fd=(int)::syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+#endif
+  }
+
+  ~branch_miss_counter()
+  {
+#if defined(__linux__)
+    if(fd>=0)::close(fd);
+#endif
+  }
+
+  template<typename F>
+  double operator()(F f,std::size_t n)const
+  {
+    if(fd<0)return -1.0;
+    long long count=0;
+#if defined(__linux__)
+    ::ioctl(fd,PERF_EVENT_IOC_RESET,0);
+    ::ioctl(fd,PERF_EVENT_IOC_ENABLE,0);
+    f();
+    ::ioctl(fd,PERF_EVENT_IOC_DISABLE,0);
+    if(::read(fd,&count,sizeof(count))!=sizeof(count))return -1.0;
+#endif
+    return (double)count/n;
+  }
+
+  int fd=-1;
+};
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+template<typename Data,typename Input,typename Make>
+void test(
+  const char* name,const Data& data,const Input& success,
+  const Input& failure,Make make)
+{
+  static branch_miss_counter branch_misses;
+
+  std::cout<<name<<":"<<std::endl;
+  std::cout
+    <<"n;build (ns/elem);bytes/elem;"
+    <<"successful find (ns);unsuccessful find (ns);"
+    <<"successful mispredicts;unsuccessful mispredicts;"<<std::endl;
+
+  unsigned int n0=1000,dn=1000;
+  double       fdn=1.5;
+  for(unsigned int n=n0;n<=data.size();n+=dn,dn=(unsigned int)(dn*fdn)){
+    auto first=data.begin(),last=data.begin()+n;
+
+    auto build=measure([&]{
+      auto s=make(first,last);
+      return s.size();
+    });
+
+    auto bytes0=allocated_bytes;
+    auto s=make(first,last);
+    auto bytes=allocated_bytes-bytes0;
+
+    auto sfirst=success.begin(),slast=success.begin()+n;
+    auto ffirst=failure.begin(),flast=failure.begin()+n;
+    std::cout
+      <<n<<";"
+      <<build*1E9/n<<";"
+      <<(double)bytes/n<<";"
+      <<measure([&]{return find_all{}(sfirst,slast,s);})*1E9/n<<";"
+      <<measure([&]{return find_all{}(ffirst,flast,s);})*1E9/n<<";"
+      <<branch_misses([&]{find_all{}(sfirst,slast,s);},n)<<";"
+      <<branch_misses([&]{find_all{}(ffirst,flast,s);},n)<<";"
+      <<std::endl;
+  }
+}
+
+template<typename T,typename Hash>
+struct minimal_set:hd::perfect_set<T,Hash,std::equal_to<T>,counting_allocator<T>>
+{
+  using super=hd::perfect_set<T,Hash,std::equal_to<T>,counting_allocator<T>>;
+  using super::super;
+  std::size_t size()const{return this->end()-this->begin();}
+};
+
+template<typename T,typename Hash>
+using nonminimal_set=hd::nonminimal_perfect_set<
+  T,Hash,std::equal_to<T>,counting_allocator<T>>;
+
+template<typename T,typename Hash,typename Data,typename Input>
+void test_all(const Data& data,const Input& success,const Input& failure)
+{
+  using minimal=minimal_set<T,Hash>;
+  using nonminimal=nonminimal_set<T,Hash>;
+
+  test(
+    "hd::perfect_set",data,success,failure,
+    [](auto first,auto last){return minimal(first,last);});
+  for(double load_factor:{0.9,0.8,0.7}){
+    auto name="hd::nonminimal_perfect_set, lf="+std::to_string(load_factor);
+    test(
+      name.c_str(),data,success,failure,
+      [=](auto first,auto last){
+        return nonminimal(
+          first,last,nonminimal::default_lambda,load_factor);
+      });
+  }
+}
+
+static std::string make_string(std::size_t x)
+{
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"pfx_%zu_sfx",x);
+  return buffer;
+}
+
+int main()
+{
+  static constexpr std::size_t N=1'000'000;
+  {
+    using value_type=std::size_t;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    for(std::size_t i=0;i<N;++i)data.push_back(dist(gen));
+
+    auto success=data;
+    std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+    auto failure=success;
+    for(auto& x:failure)x+=1;
+
+    std::cout<<"integers"<<std::endl;
+    test_all<value_type,hd::mbs_hash>(data,success,failure);
+  }
+  {
+    using value_type=std::string;
+
+    std::mt19937                               gen(0);
+    std::uniform_int_distribution<std::size_t> dist;
+    std::vector<value_type>                    data;
+
+    for(std::size_t i=0;i<N;++i)data.push_back(make_string(dist(gen)));
+
+    auto success=data;
+    std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+    auto failure=success;
+    for(auto& x:failure)x[x.size()/2]='*';
+
+    std::cout<<"strings"<<std::endl;
+    test_all<value_type,hd::mulxp3_string_hash>(data,success,failure);
+  }
+}
@@ -0,0 +1,161 @@
+/* Measuring multithreaded lookup performance of NUMA-replicated
+ * perfect sets.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <atomic>
+#include <boost/core/detail/splitmix64.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "fks_perfect_set.hpp"
+#include "numa_replicated_set.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+/* each thread is pinned to a CPU and looks up its own slice of the input */
+
+struct parallel_find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c,
+    std::size_t num_threads)const
+  {
+    std::atomic<std::size_t> res=0;
+    std::vector<std::thread> threads;
+    auto n=static_cast<std::size_t>(std::distance(first,last));
+    for(std::size_t i=0;i<num_threads;++i){
+      threads.emplace_back([&,i]{
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(i,&set);
+        ::sched_setaffinity(0,sizeof(set),&set);
+#endif
+        auto ifirst=first+n*i/num_threads,ilast=first+n*(i+1)/num_threads;
+        std::size_t r=0;
+        while(ifirst!=ilast){
+          if(c.find(*ifirst++)!=c.end())++r;
+        }
+        res+=r;
+      });
+    }
+    for(auto& t:threads)t.join();
+    return res;
+  }
+};
+
+template<typename Set,typename Data>
+void test(
+  const char* title,const Data& data,
+  std::size_t num_nodes,std::size_t num_threads)
+{
+  using replicated_set=hd::numa_replicated_set<Set>;
+
+  Set            s(data.begin(),data.end());
+  replicated_set rs(data.begin(),data.end(),num_nodes);
+
+  auto input=data;
+  std::shuffle(input.begin(),input.end(),splitmix64_urng{31321});
+  auto first=input.begin(),last=input.end();
+  auto n=input.size();
+
+  std::cout<<title<<" ("<<data.size()<<" elements, "
+           <<rs.num_nodes()<<" nodes, "<<num_threads<<" threads):\n";
+  std::cout<<"shared;replicated;\n";
+  std::cout
+    <<measure([&]{return parallel_find_all{}(first,last,s,num_threads);})
+      *1E9/n<<";"
+    <<measure([&]{return parallel_find_all{}(first,last,rs,num_threads);})
+      *1E9/n<<";\n";
+  std::cout<<"node;bytes;bits/element;\n";
+  for(std::size_t node=0;node<rs.num_nodes();++node){
+    std::cout<<node<<";"<<rs.memory(node)<<";"
+             <<rs.memory(node)*8.0/data.size()<<";\n";
+  }
+}
+
+int main(int argc,char* argv[])
+{
+  /* numa_lookup [num_nodes [num_threads]]; num_nodes greater than
+   * the physical number of nodes simulates placement.
+   */
+
+  std::size_t num_nodes=argc>1?std::strtoul(argv[1],nullptr,10):0;
+  std::size_t num_threads=argc>2?
+    std::strtoul(argv[2],nullptr,10):std::thread::hardware_concurrency();
+  if(!num_threads)num_threads=1;
+
+  static constexpr std::size_t N=10'000'000;
+  using value_type=std::size_t;
+  using allocator_type=hd::numa_node_allocator<value_type>;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  for(std::size_t i=0;i<N;++i)data.push_back(dist(gen));
+
+  test<hd::perfect_set<
+    value_type,hd::mbs_hash,std::equal_to<value_type>,allocator_type>>(
+      "hd::perfect_set mbs",data,num_nodes,num_threads);
+
+  data.resize(N/100); /* FKS construction is much slower */
+  test<fks::perfect_set<
+    value_type,hd::m_hash,std::equal_to<value_type>,allocator_type>>(
+      "fks::perfect_set m",data,num_nodes,num_threads);
+}
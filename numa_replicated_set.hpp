@@ -0,0 +1,335 @@
+/* NUMA-replicated wrapper over perfect sets.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef NUMA_REPLICATED_SET_HPP
+#define NUMA_REPLICATED_SET_HPP
+
+#include <atomic>
+#include <boost/config.hpp>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace hd{
+
+/* NUMA topology as read from /sys/devices/system/node. Machines without
+ * NUMA information are reported as having one node with all the CPUs.
+ */
+
+struct numa_topology
+{
+  numa_topology()
+  {
+#if defined(__linux__)
+    for(std::size_t node=0;;++node){
+      auto cpus=read_cpu_list(
+        "/sys/devices/system/node/node"+std::to_string(node)+"/cpulist");
+      if(cpus.empty())break;
+      node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    if(node_cpus.empty()){
+      node_cpus.emplace_back();
+      auto n=std::thread::hardware_concurrency();
+      for(unsigned int cpu=0;cpu<(n?n:1);++cpu)node_cpus[0].push_back(cpu);
+    }
+    for(std::size_t node=0;node<node_cpus.size();++node){
+      for(auto cpu:node_cpus[node]){
+        if(cpu>=cpu_nodes.size())cpu_nodes.resize(cpu+1,0);
+        cpu_nodes[cpu]=node;
+      }
+    }
+  }
+
+  std::size_t num_nodes()const{return node_cpus.size();}
+
+  static std::size_t current_cpu()
+  {
+#if defined(__linux__)
+    auto cpu=::sched_getcpu();
+    if(cpu>=0)return static_cast<std::size_t>(cpu);
+#endif
+    return 0;
+  }
+
+  std::size_t node_of_cpu(std::size_t cpu)const
+  {
+    return cpu<cpu_nodes.size()?cpu_nodes[cpu]:0;
+  }
+
+  std::vector<std::vector<unsigned int>> node_cpus;
+  std::vector<std::size_t>               cpu_nodes;
+
+private:
+  static std::vector<unsigned int> read_cpu_list(const std::string& path)
+  {
+    /* format is "0-3,8-11" */
+
+    std::vector<unsigned int> res;
+#if defined(__linux__)
+    auto f=std::fopen(path.c_str(),"r");
+    if(!f)return res;
+    unsigned int first,last;
+    for(;;){
+      if(std::fscanf(f,"%u",&first)!=1)break;
+      last=first;
+      int c=std::fgetc(f);
+      if(c=='-'){
+        if(std::fscanf(f,"%u",&last)!=1)break;
+        c=std::fgetc(f);
+      }
+      for(auto cpu=first;cpu<=last;++cpu)res.push_back(cpu);
+      if(c!=',')break;
+    }
+    std::fclose(f);
+#else
+    (void)path;
+#endif
+    return res;
+  }
+};
+
+/* Allocator binding its memory to a given NUMA node with mbind (no libnuma
+ * required). If the binding fails (for instance, on kernels without NUMA
+ * support), placement falls back to first-touch by the allocating thread.
+ * Live bytes are accounted into the counter provided.
+ */
+
+template<typename T>
+struct numa_node_allocator
+{
+  using value_type=T;
+
+  numa_node_allocator(
+    std::size_t node_=0,std::atomic<std::size_t>* counter_=nullptr):
+    node{node_},counter{counter_}{}
+  template<typename U>
+  numa_node_allocator(const numa_node_allocator<U>& x)noexcept:
+    node{x.node},counter{x.counter}{}
+
+  T* allocate(std::size_t n)
+  {
+    if(n>(std::numeric_limits<std::size_t>::max)()/sizeof(T)){
+      throw std::bad_array_new_length{};
+    }
+    auto len=mapping_size(n*sizeof(T));
+#if defined(__linux__)
+    auto p=::mmap(
+      nullptr,len,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    if(p==MAP_FAILED)throw std::bad_alloc{};
+    if(node<sizeof(unsigned long)*CHAR_BIT){
+      static constexpr int mpol_bind=2;
+      unsigned long nodemask=1ul<<node;
+      ::syscall(
+        SYS_mbind,p,len,mpol_bind,&nodemask,sizeof(nodemask)*CHAR_BIT,0);
+    }
+#else
+    auto p=::operator new(len);
+#endif
+    if(counter)counter->fetch_add(len,std::memory_order_relaxed);
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p,std::size_t n)noexcept
+  {
+    auto len=mapping_size(n*sizeof(T));
+#if defined(__linux__)
+    ::munmap(p,len);
+#else
+    ::operator delete(p);
+#endif
+    if(counter)counter->fetch_sub(len,std::memory_order_relaxed);
+  }
+
+  friend bool operator==(
+    const numa_node_allocator& x,const numa_node_allocator& y)
+  {
+    return x.node==y.node&&x.counter==y.counter;
+  }
+
+  friend bool operator!=(
+    const numa_node_allocator& x,const numa_node_allocator& y)
+  {
+    return !(x==y);
+  }
+
+  std::size_t               node;
+  std::atomic<std::size_t>* counter;
+
+private:
+  static std::size_t mapping_size(std::size_t bytes)
+  {
+    static constexpr std::size_t page_size=4096;
+    if(!bytes)bytes=1;
+    return (bytes+page_size-1)/page_size*page_size;
+  }
+};
+
+/* Builds Set once and copies its immutable arrays to every NUMA node,
+ * each copy being made by a thread pinned to the CPUs of the destination
+ * node. Lookups go to the replica local to the calling thread's node.
+ * Set::allocator_type must be a numa_node_allocator.
+ *
+ * A number of nodes larger than the physical one can be requested to
+ * simulate placement on single-node machines: simulated node i is then
+ * mapped onto physical node i%num_physical_nodes, and threads are
+ * assigned to simulated nodes by CPU number.
+ */
+
+template<typename Set>
+class numa_replicated_set
+{
+public:
+  using set_type=Set;
+  using key_type=typename set_type::key_type;
+  using value_type=typename set_type::value_type;
+  using hasher=typename set_type::hasher;
+  using allocator_type=typename set_type::allocator_type;
+  using iterator=typename set_type::iterator;
+
+  template<typename FwdIterator>
+  numa_replicated_set(
+    FwdIterator first,FwdIterator last,std::size_t num_nodes=0,
+    std::size_t lambda=set_type::default_lambda):
+    num_replicas{num_nodes?num_nodes:topology.num_nodes()},
+    counters{new std::atomic<std::size_t>[num_replicas]},
+    replicas(num_replicas)
+  {
+    for(std::size_t i=0;i<num_replicas;++i)counters[i]=0;
+    run_on_node(0,[&]{
+      replicas[0].reset(
+        new set_type(first,last,lambda,allocator_type(0,&counters[0])));
+    });
+
+    /* errors are rethrown once all threads are joined */
+
+    std::vector<std::exception_ptr> errors(num_replicas);
+    std::vector<std::thread>        threads;
+    try{
+      for(std::size_t i=1;i<num_replicas;++i){
+        threads.emplace_back([&,i]{
+          try{
+            pin_to_node(i);
+            replicas[i].reset(new set_type(
+              *replicas[0],
+              allocator_type(physical_node(i),&counters[i])));
+          }
+          catch(...){
+            errors[i]=std::current_exception();
+          }
+        });
+      }
+    }
+    catch(...){
+      for(auto& t:threads)t.join();
+      throw;
+    }
+    for(auto& t:threads)t.join();
+    for(const auto& e:errors)if(e)std::rethrow_exception(e);
+  }
+
+  std::size_t num_nodes()const{return num_replicas;}
+  const set_type& replica(std::size_t node)const{return *replicas[node];}
+  const set_type& local_replica()const{return *replicas[current_node()];}
+
+  /* live bytes allocated on behalf of each node's replica */
+
+  std::size_t memory(std::size_t node)const
+  {
+    return counters[node].load(std::memory_order_relaxed);
+  }
+
+  /* threads are assumed not to migrate across nodes, so the node is
+   * determined only on first use.
+   */
+
+  std::size_t current_node()const
+  {
+    static thread_local std::size_t cpu=numa_topology::current_cpu();
+    if(num_replicas==topology.num_nodes())return topology.node_of_cpu(cpu);
+    else                                  return cpu%num_replicas;
+  }
+
+  hasher hash_function()const{return replicas[0]->hash_function();}
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find(const Key& x)const
+  {
+    return local_replica().find(x);
+  }
+
+  template<typename Key>
+  BOOST_FORCEINLINE iterator find_hashed(const Key& x,std::size_t hash)const
+  {
+    return local_replica().find_hashed(x,hash);
+  }
+
+  /* end() of the local replica, to be compared with find's result */
+
+  iterator end()const{return local_replica().end();}
+
+private:
+  std::size_t physical_node(std::size_t node)const
+  {
+    return node%topology.num_nodes();
+  }
+
+  void pin_to_node(std::size_t node)const
+  {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(auto cpu:topology.node_cpus[physical_node(node)])CPU_SET(cpu,&set);
+    ::sched_setaffinity(0,sizeof(set),&set);
+#else
+    (void)node;
+#endif
+  }
+
+  template<typename F>
+  void run_on_node(std::size_t node,F f)const
+  {
+    std::exception_ptr error;
+    std::thread t([&]{
+      try{
+        pin_to_node(node);
+        f();
+      }
+      catch(...){
+        error=std::current_exception();
+      }
+    });
+    t.join();
+    if(error)std::rethrow_exception(error);
+  }
+
+  inline static const numa_topology topology;
+
+  std::size_t                                 num_replicas;
+  std::unique_ptr<std::atomic<std::size_t>[]> counters;
+  std::vector<std::unique_ptr<set_type>>      replicas;
+};
+
+} /* namespace hd */
+
+#endif
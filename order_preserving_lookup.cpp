@@ -0,0 +1,188 @@
+/* Order-preserving lookup: hd::order_preserving_perfect_set vs.
+ * hd::perfect_set plus a permutation array.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "hd_order_preserving_perfect_set.hpp"
+#include "counting_allocator.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+struct sum_all
+{
+  using result_type=std::uint64_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::uint64_t res=0;
+    while(first!=last)res+=c.index_of(*first++);
+    return res;
+  }
+};
+
+/* bits/elem counts the index only, not the elements */
+
+template<typename Data,typename Indices,typename Make>
+void test(
+  const char* name,const Data& data,const Indices& success,Make make)
+{
+  using value_type=typename Data::value_type;
+
+  std::cout<<name<<":"<<std::endl;
+  std::cout<<"n;build (ns/elem);bits/elem;index_of (ns);"<<std::endl;
+
+  for(std::size_t n=1000;n<=data.size();n*=10){
+    auto first=data.begin(),last=data.begin()+n;
+
+    auto build=measure([&]{
+      auto s=make(first,last);
+      return s.size();
+    });
+
+    auto bytes0=allocated_bytes;
+    auto s=make(first,last);
+    auto bytes=allocated_bytes-bytes0-n*sizeof(value_type);
+
+    Data input;
+    for(const auto& x:success)if(x<n)input.push_back(data[x]);
+    auto ifirst=input.begin(),ilast=input.end();
+    std::cout
+      <<n<<";"
+      <<build*1E9/n<<";"
+      <<(double)bytes*8/n<<";"
+      <<measure([&]{return sum_all{}(ifirst,ilast,s);})*1E9/n<<";"
+      <<std::endl;
+  }
+}
+
+/* hd::perfect_set with an array mapping its slots to input ranks */
+
+template<typename T,typename Hash>
+struct permuted_set:hd::perfect_set<
+  T,Hash,std::equal_to<T>,counting_allocator<T>>
+{
+  using super=hd::perfect_set<T,Hash,std::equal_to<T>,counting_allocator<T>>;
+
+  template<typename FwdIterator>
+  permuted_set(FwdIterator first,FwdIterator last):
+    super(first,last),ranks(static_cast<std::size_t>(last-first))
+  {
+    for(std::uint32_t i=0;first!=last;++first,++i){
+      ranks[this->find(*first)-this->begin()]=i;
+    }
+  }
+
+  std::size_t size()const{return ranks.size();}
+
+  std::size_t index_of(const T& x)const
+  {
+    auto it=this->find(x);
+    return it!=this->end()?ranks[it-this->begin()]:size();
+  }
+
+  std::vector<std::uint32_t,counting_allocator<std::uint32_t>> ranks;
+};
+
+template<typename T,typename Hash>
+using order_preserving_set=hd::order_preserving_perfect_set<
+  T,Hash,std::equal_to<T>,counting_allocator<T>>;
+
+static std::string make_string(std::size_t x)
+{
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"pfx_%zu_sfx",x);
+  return buffer;
+}
+
+template<typename T,typename Hash,typename Make>
+void test_all(Make make_key)
+{
+  static constexpr std::size_t N=1'000'000;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<T>                             data;
+
+  for(std::size_t i=0;i<N;++i)data.push_back(make_key(dist(gen)));
+
+  /* indices of the successful lookups */
+
+  std::vector<std::size_t> success(N);
+  for(std::size_t i=0;i<N;++i)success[i]=i;
+  std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+
+  test(
+    "hd::perfect_set + permutation",data,success,
+    [](auto first,auto last){return permuted_set<T,Hash>(first,last);});
+  test(
+    "hd::order_preserving_perfect_set",data,success,
+    [](auto first,auto last){
+      return order_preserving_set<T,Hash>(first,last);});
+}
+
+int main()
+{
+  std::cout<<"integers"<<std::endl;
+  /* mulx rather than mbs, which is very slow to build for some sizes */
+
+  test_all<std::size_t,hd::mulx_hash>([](std::size_t x){return x;});
+  std::cout<<"strings"<<std::endl;
+  test_all<std::string,hd::mulxp3_string_hash>(make_string);
+}
@@ -0,0 +1,135 @@
+/* Fixed-width bit-packed array of unsigned values.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef PACKED_ARRAY_HPP
+#define PACKED_ARRAY_HPP
+
+#include <boost/config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hd{
+
+/* Read-only access to the words of a packed_array held elsewhere (e.g. in
+ * a memory-mapped file).
+ */
+
+class packed_array_view
+{
+public:
+  packed_array_view(
+    const std::uint64_t* words_,std::size_t n,std::size_t width_):
+    words{words_},size_{n},width{width_},mask{mask_for(width_)}{}
+
+  static constexpr std::uint64_t mask_for(std::size_t width)
+  {
+    return width>=64?~std::uint64_t(0):(std::uint64_t(1)<<width)-1;
+  }
+
+  /* words taken by n values of width bits, padding word included: at
+   * least two, as get() reads words[0] and words[1] even with width 0
+   */
+
+  static constexpr std::size_t num_words(std::size_t n,std::size_t width)
+  {
+    return (n*width+63)/64+(width?1:2);
+  }
+
+  std::size_t size()const{return size_;}
+  std::size_t value_width()const{return width;}
+
+  BOOST_FORCEINLINE std::uint64_t get(std::size_t i)const
+  {
+    auto bit=i*width;
+    auto w=bit/64,o=bit%64;
+    auto lo=words[w]>>o;
+    auto hi=(words[w+1]<<1)<<(63-o); /* avoids shifting by 64 when o==0 */
+    return (lo|hi)&mask;
+  }
+
+private:
+  const std::uint64_t* words;
+  std::size_t          size_;
+  std::size_t          width;
+  std::uint64_t        mask;
+};
+
+/* Values of width bits (0<=width<=64) stored back to back in 64-bit words.
+ * A trailing padding word lets get() read two consecutive words
+ * unconditionally.
+ */
+
+template<typename Allocator=std::allocator<std::uint64_t>>
+class packed_array
+{
+  using word_allocator_type=typename std::allocator_traits<Allocator>::
+    template rebind_alloc<std::uint64_t>;
+
+public:
+  using allocator_type=Allocator;
+
+  explicit packed_array(const allocator_type& al=allocator_type()):
+    words(word_allocator_type(al)){}
+
+  packed_array(
+    std::size_t n,std::size_t width_,
+    const allocator_type& al=allocator_type()):
+    size_{n},width{width_},mask{packed_array_view::mask_for(width_)},
+    words(packed_array_view::num_words(n,width_),0,word_allocator_type(al))
+  {}
+
+  std::size_t size()const{return size_;}
+  std::size_t value_width()const{return width;}
+
+  /* memory used, in bits */
+
+  std::size_t capacity_in_bits()const{return words.size()*64;}
+
+  /* raw storage, as expected by packed_array_view */
+
+  const std::uint64_t* data()const{return words.data();}
+  std::size_t          num_words()const{return words.size();}
+
+  packed_array_view view()const{return {words.data(),size_,width};}
+
+  BOOST_FORCEINLINE std::uint64_t get(std::size_t i)const
+  {
+    auto bit=i*width;
+    auto w=bit/64,o=bit%64;
+    auto lo=words[w]>>o;
+    auto hi=(words[w+1]<<1)<<(63-o); /* avoids shifting by 64 when o==0 */
+    return (lo|hi)&mask;
+  }
+
+  void set(std::size_t i,std::uint64_t x)
+  {
+    x&=mask;
+    auto bit=i*width;
+    auto w=bit/64,o=bit%64;
+    words[w]=(words[w]&~(mask<<o))|(x<<o);
+    if(o+width>64){
+      auto hbits=o+width-64;
+      auto hmask=(std::uint64_t(1)<<hbits)-1;
+      words[w+1]=(words[w+1]&~hmask)|(x>>(64-o));
+    }
+  }
+
+private:
+  using word_array=std::vector<std::uint64_t,word_allocator_type>;
+
+  std::size_t   size_=0;
+  std::size_t   width=0;
+  std::uint64_t mask=0;
+  word_array    words;
+};
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,110 @@
+/* Construction time of hd::perfect_set with concurrent placement
+ * against the number of threads.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hd_perfect_set.hpp"
+
+template<typename Data>
+void test(const Data& data,std::size_t max_threads)
+{
+  using container=hd::perfect_set<typename Data::value_type,hd::mulx_hash>;
+
+  auto n=data.size();
+  auto sequential=measure([&]{
+    container c(data.begin(),data.end());
+    return c.end()-c.begin();
+  });
+  std::cout<<n<<";1;"<<sequential*1E9/n<<";1;"<<std::endl;
+
+  for(std::size_t num_threads=2;num_threads<=max_threads;num_threads*=2){
+    auto parallel=measure([&]{
+      container c(
+        data.begin(),data.end(),hd::parallel_construction{num_threads});
+      return c.end()-c.begin();
+    });
+
+    /* all elements must be found */
+
+    container c(
+      data.begin(),data.end(),hd::parallel_construction{num_threads});
+    for(const auto& x:data){
+      if(c.find(x)==c.end()){
+        std::cerr<<"element not found"<<std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    std::cout
+      <<n<<";"<<num_threads<<";"<<parallel*1E9/n<<";"
+      <<sequential/parallel<<";"<<std::endl;
+  }
+}
+
+int main(int argc,char* argv[])
+{
+  /* parallel_build [max_n [max_threads]] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):4'000'000;
+  std::size_t max_threads=argc>2?
+    std::strtoull(argv[2],nullptr,10):
+    (std::max)(2u,std::thread::hardware_concurrency());
+
+  using value_type=std::size_t;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  std::cout<<"n;threads;build (ns/elem);speedup;"<<std::endl;
+  for(std::size_t n=10'000;n<=max_n;n*=10){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    test(data,max_threads);
+  }
+}
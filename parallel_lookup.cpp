@@ -0,0 +1,128 @@
+/* Scaling of parallel_find_all and parallel_find_many with the number of
+ * threads.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "fks_perfect_set.hpp"
+#include "parallel_lookup.hpp"
+
+/* num_queries random queries, half of them successful */
+
+static constexpr std::size_t num_queries=10'000'000;
+
+template<typename Container,typename Data>
+void test(const char* title,const Data& data,std::size_t max_threads)
+{
+  Container    s(data.begin(),data.end());
+  Data         queries;
+  std::mt19937 gen(data.size());
+  std::uniform_int_distribution<std::size_t> dist(0,data.size()-1);
+  for(std::size_t i=0;i<num_queries;++i){
+    queries.push_back(data[dist(gen)]+(i%2));
+  }
+  std::vector<unsigned char> flags(num_queries);
+  std::vector<std::uint32_t> slots(num_queries);
+
+  std::cout<<title<<" ("<<data.size()<<" elements):"<<std::endl;
+  std::cout
+    <<"threads;parallel_find_all (ns);speedup;"
+    <<"parallel_find_many (ns);speedup;"<<std::endl;
+  double t1_all=0,t1_many=0;
+  for(std::size_t num_threads=1;num_threads<=max_threads;num_threads*=2){
+    auto t_all=measure([&]{
+      hd::parallel_find_all(
+        s,queries.begin(),queries.end(),flags.begin(),num_threads);
+      return flags[0];
+    })*1E9/num_queries;
+    auto t_many=measure([&]{
+      hd::parallel_find_many(
+        s,queries.begin(),queries.end(),slots.begin(),num_threads);
+      return slots[0];
+    })*1E9/num_queries;
+    if(num_threads==1){
+      t1_all=t_all;
+      t1_many=t_many;
+    }
+    std::cout
+      <<num_threads<<";"
+      <<t_all<<";"<<t1_all/t_all<<";"
+      <<t_many<<";"<<t1_many/t_many<<";"<<std::endl;
+  }
+}
+
+int main(int argc,char* argv[])
+{
+  /* parallel_lookup [max_threads] */
+
+  std::size_t max_threads=argc>1?
+    std::strtoul(argv[1],nullptr,10):std::thread::hardware_concurrency();
+  if(!max_threads)max_threads=1;
+
+  using value_type=std::size_t;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  for(std::size_t n:{100'000,1'000'000,10'000'000}){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    test<hd::perfect_set<value_type,hd::mbs_hash>>(
+      "hd::perfect_set mbs",data,max_threads);
+  }
+
+  /* FKS construction is much slower */
+
+  for(std::size_t n:{10'000,100'000}){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    test<fks::perfect_set<value_type,hd::m_hash>>(
+      "fks::perfect_set m",data,max_threads);
+  }
+}
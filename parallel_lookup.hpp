@@ -0,0 +1,135 @@
+/* Parallel bulk lookup over large query ranges.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef PARALLEL_LOOKUP_HPP
+#define PARALLEL_LOOKUP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace hd{
+
+/* Calls f(i,j) on consecutive chunks [i,j) covering [0,n) from num_threads
+ * threads (the calling one included). Every thread starts off with an
+ * equal share of the chunks and, when done, steals the remaining chunks
+ * of the others.
+ */
+
+template<typename F>
+void parallel_for_chunks(
+  std::size_t n,std::size_t chunk_size,std::size_t num_threads,F f)
+{
+  if(!num_threads)num_threads=std::thread::hardware_concurrency();
+  auto num_chunks=(n+chunk_size-1)/chunk_size;
+  num_threads=(std::max)(std::size_t(1),(std::min)(num_threads,num_chunks));
+  if(num_threads==1){
+    for(std::size_t i=0;i<n;i+=chunk_size)f(i,(std::min)(n,i+chunk_size));
+    return;
+  }
+
+  struct alignas(64) share
+  {
+    std::atomic<std::size_t> next;
+    std::size_t              last;
+  };
+
+  std::unique_ptr<share[]> shares{new share[num_threads]};
+  for(std::size_t t=0;t<num_threads;++t){
+    shares[t].next=num_chunks*t/num_threads;
+    shares[t].last=num_chunks*(t+1)/num_threads;
+  }
+
+  auto work=[&](std::size_t t){
+    for(std::size_t k=0;k<num_threads;++k){
+      auto& s=shares[(t+k)%num_threads];
+      for(;;){
+        auto c=s.next.fetch_add(1,std::memory_order_relaxed);
+        if(c>=s.last)break;
+        f(c*chunk_size,(std::min)(n,(c+1)*chunk_size));
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(std::size_t t=1;t<num_threads;++t)threads.emplace_back(work,t);
+  work(0);
+  for(auto& t:threads)t.join();
+}
+
+namespace detail{
+
+static constexpr std::size_t parallel_lookup_chunk_size=4096;
+static constexpr std::size_t parallel_lookup_batch_size=256;
+
+/* looks up chunks with s.find_many and passes the results to g(i,it) */
+
+template<typename Set,typename RandomAccessIterator,typename G>
+void parallel_find(
+  const Set& s,RandomAccessIterator first,RandomAccessIterator last,
+  std::size_t num_threads,G g)
+{
+  parallel_for_chunks(
+    static_cast<std::size_t>(last-first),parallel_lookup_chunk_size,
+    num_threads,
+    [&](std::size_t i,std::size_t j){
+      typename Set::iterator results[parallel_lookup_batch_size];
+      while(i<j){
+        auto k=(std::min)(j,i+parallel_lookup_batch_size);
+        s.find_many(first+i,first+k,results);
+        for(auto it=results;i<k;++i,++it)g(i,*it);
+      }
+    });
+}
+
+} /* namespace detail */
+
+/* flags[i] is set to whether first[i] is in s. num_threads==0 means
+ * std::thread::hardware_concurrency(). Set must provide find_many. As
+ * flags are written concurrently, they can't be packed bits (e.g. a
+ * std::vector<bool>).
+ */
+
+template<
+  typename Set,typename RandomAccessIterator,
+  typename RandomAccessOutputIterator
+>
+void parallel_find_all(
+  const Set& s,RandomAccessIterator first,RandomAccessIterator last,
+  RandomAccessOutputIterator flags,std::size_t num_threads=0)
+{
+  auto end_=s.end();
+  detail::parallel_find(
+    s,first,last,num_threads,
+    [&](std::size_t i,typename Set::iterator it){flags[i]=it!=end_;});
+}
+
+/* slots[i] is set to the position of first[i] in [s.begin(),s.end()), or
+ * to s.end()-s.begin() if not found.
+ */
+
+template<
+  typename Set,typename RandomAccessIterator,
+  typename RandomAccessOutputIterator
+>
+void parallel_find_many(
+  const Set& s,RandomAccessIterator first,RandomAccessIterator last,
+  RandomAccessOutputIterator slots,std::size_t num_threads=0)
+{
+  auto begin_=s.begin();
+  detail::parallel_find(
+    s,first,last,num_threads,
+    [&](std::size_t i,typename Set::iterator it){slots[i]=it-begin_;});
+}
+
+} /* namespace hd */
+
+#endif
@@ -0,0 +1,148 @@
+/* Comparing prefetching find_many with radix-partitioned
+ * find_partitioned over query batches of varying size at DRAM-resident
+ * sizes.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "hd_perfect_set.hpp"
+
+/* num_queries random queries are looked up in batches of batch_size */
+
+static constexpr std::size_t num_queries=1'000'000;
+
+template<typename Container,typename Input>
+struct find_many_batches
+{
+  using result_type=std::size_t;
+
+  BOOST_NOINLINE result_type operator()()const
+  {
+    std::size_t res=0;
+    for(auto first=queries.begin();first!=queries.end();first+=batch_size){
+      c.find_many(first,first+batch_size,results.begin());
+      for(auto it:results)if(it!=c.end())++res;
+    }
+    return res;
+  }
+
+  const Container&                           c;
+  const Input&                               queries;
+  std::size_t                                batch_size;
+  std::vector<typename Container::iterator>& results;
+};
+
+template<typename Container,typename Input>
+struct find_partitioned_batches
+{
+  using result_type=std::size_t;
+
+  BOOST_NOINLINE result_type operator()()const
+  {
+    std::size_t res=0;
+    for(auto first=queries.begin();first!=queries.end();first+=batch_size){
+      c.find_partitioned(first,first+batch_size,results.begin());
+      for(auto it:results)if(it!=c.end())++res;
+    }
+    return res;
+  }
+
+  const Container&                           c;
+  const Input&                               queries;
+  std::size_t                                batch_size;
+  std::vector<typename Container::iterator>& results;
+};
+
+template<typename Container,typename Data,typename Input>
+void test(
+  const char* title,const Data& data,const Input& input,std::size_t max_n)
+{
+  std::cout<<title<<":"<<std::endl;
+
+  for(std::size_t n=1'000'000;n<=(std::min)(max_n,data.size());n*=4){
+    Container    s(data.begin(),data.begin()+n);
+    Input        queries;
+    std::mt19937 gen(n);
+    std::uniform_int_distribution<std::size_t> dist(0,n-1);
+    for(std::size_t i=0;i<num_queries;++i)queries.push_back(input[dist(gen)]);
+
+    std::cout<<"n="<<n<<std::endl;
+    std::cout<<"batch size;find_many (ns);find_partitioned (ns);"<<std::endl;
+    for(std::size_t batch_size=1'000;batch_size<=num_queries;batch_size*=10){
+      std::vector<typename Container::iterator> results(batch_size);
+      std::cout
+        <<batch_size<<";"
+        <<measure(find_many_batches<Container,Input>{
+            s,queries,batch_size,results})*1E9/num_queries<<";"
+        <<measure(find_partitioned_batches<Container,Input>{
+            s,queries,batch_size,results})*1E9/num_queries<<";"
+        <<std::endl;
+    }
+  }
+}
+
+int main(int argc,char* argv[])
+{
+  /* partitioned_lookup [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):64'000'000;
+
+  using value_type=std::size_t;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  for(std::size_t i=0;i<max_n;++i)data.push_back(dist(gen));
+
+  using container=hd::perfect_set<value_type,hd::mbs_hash>;
+
+  test<container>("Successful find, integers",data,data,max_n);
+
+  auto input=data;
+  for(auto& x:input)x+=1;
+
+  test<container>("Unsuccessful find, integers",data,input,max_n);
+}
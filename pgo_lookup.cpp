@@ -0,0 +1,150 @@
+/* Lookup performance of hd::perfect_set with and without profile-guided
+ * layout under Zipfian workloads.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "hd_perfect_set.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+struct find_all
+{
+  using result_type=std::size_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::size_t res=0;
+    while(first!=last){
+      if(c.find(*first++)!=c.end())++res;
+    }
+    return res;
+  }
+};
+
+/* Element i is queried with probability proportional to 1/(rank(i)+1)^s,
+ * ranks being randomly assigned. Weights are taken from the counts of a
+ * training trace independent of the measured one.
+ */
+
+static constexpr std::size_t num_queries=1'000'000;
+static constexpr std::size_t num_training_queries=10'000'000;
+
+template<typename Data>
+void test(const Data& data,double s)
+{
+  using container=hd::perfect_set<typename Data::value_type,hd::mbs_hash>;
+
+  auto n=data.size();
+  std::vector<std::size_t> ranks(n);
+  std::iota(ranks.begin(),ranks.end(),0);
+  std::shuffle(ranks.begin(),ranks.end(),splitmix64_urng{n});
+  std::vector<double> probabilities(n);
+  for(std::size_t i=0;i<n;++i){
+    probabilities[i]=1.0/std::pow((double)(ranks[i]+1),s);
+  }
+  std::discrete_distribution<std::size_t> dist(
+    probabilities.begin(),probabilities.end());
+
+  std::mt19937             gen(0);
+  std::vector<std::size_t> weights(n,0);
+  for(std::size_t i=0;i<num_training_queries;++i)++weights[dist(gen)];
+
+  Data queries;
+  for(std::size_t i=0;i<num_queries;++i)queries.push_back(data[dist(gen)]);
+  auto qfirst=queries.begin(),qlast=queries.end();
+
+  auto build=measure([&]{
+    container c(data.begin(),data.end());
+    return c.end()-c.begin();
+  });
+  auto weighted_build=measure([&]{
+    container c(data.begin(),data.end(),weights.begin());
+    return c.end()-c.begin();
+  });
+  container c(data.begin(),data.end());
+  container wc(data.begin(),data.end(),weights.begin());
+
+  std::cout
+    <<n<<";"<<s<<";"
+    <<build*1E9/n<<";"<<weighted_build*1E9/n<<";"
+    <<measure([&]{return find_all{}(qfirst,qlast,c);})*1E9/num_queries<<";"
+    <<measure([&]{return find_all{}(qfirst,qlast,wc);})*1E9/num_queries<<";"
+    <<std::endl;
+}
+
+int main(int argc,char* argv[])
+{
+  /* pgo_lookup [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):4'000'000;
+
+  using value_type=std::size_t;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<value_type>                    data;
+
+  std::cout
+    <<"n;s;build (ns/elem);weighted build (ns/elem);"
+    <<"lookup (ns);weighted lookup (ns);"<<std::endl;
+  for(std::size_t n=1'000'000;n<=max_n;n*=4){
+    data.clear();
+    for(std::size_t i=0;i<n;++i)data.push_back(dist(gen));
+    for(double s:{0.8,1.0,1.2})test(data,s);
+  }
+}
@@ -0,0 +1,235 @@
+/* Size policies mapping hash values to table positions, shared by
+ * hd::perfect_set and fks::perfect_set.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef SIZE_POLICIES_HPP
+#define SIZE_POLICIES_HPP
+
+#include <algorithm>
+#include <boost/core/bit.hpp>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace hd{
+
+struct pow2_lower_size_policy
+{
+  using size_index_type=std::size_t;
+
+  static constexpr inline std::size_t size_index(std::size_t n)
+  {
+    auto exp=n<=2?1:((std::size_t)(boost::core::bit_width(n-1)));
+    return (std::size_t(1)<<exp)-1;
+  }
+
+  static constexpr  inline std::size_t size(std::size_t size_index_)
+  {
+     return size_index_+1;
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  {
+    return hash&size_index_;
+  }
+};
+
+struct pow2_upper_size_policy
+{
+  using size_index_type=std::size_t;
+
+  static constexpr inline std::size_t size_index(std::size_t n)
+  {
+    return sizeof(std::size_t)*CHAR_BIT-
+      (n<=2?1:((std::size_t)(boost::core::bit_width(n-1))));
+  }
+
+  static constexpr inline std::size_t size(std::size_t size_index_)
+  {
+     return std::size_t(1)<<(sizeof(std::size_t)*CHAR_BIT-size_index_);  
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static constexpr inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  {
+    return hash>>size_index_;
+  }
+
+  /* lowest hash value mapped to pos */
+
+  static constexpr inline std::size_t preimage(std::size_t pos,std::size_t size_index_)
+  {
+    return pos<<size_index_;
+  }
+};
+
+/* Exact (non-power-of-two) sizes with Lemire's multiply-shift range
+ * reduction (https://arxiv.org/abs/1805.10941), which maps hash values
+ * into [0,n) without division. The lower variant uses the low 32 bits of
+ * the hash, the upper variant the whole hash (hence its high bits).
+ * Sizes must be less than 2^32.
+ */
+
+inline std::size_t mul_high(std::uint64_t x,std::uint64_t y)
+{
+#if defined(__SIZEOF_INT128__)
+  return static_cast<std::size_t>((static_cast<__uint128_t>(x)*y)>>64);
+#else
+  std::uint64_t x1=(std::uint32_t)x,x2=x>>32,y1=(std::uint32_t)y,y2=y>>32;
+  std::uint64_t r1=x1*y1,r2a=x1*y2,r2b=x2*y1,r3=x2*y2;
+  std::uint64_t r2=(r1>>32)+(std::uint32_t)r2a+(std::uint32_t)r2b;
+  return static_cast<std::size_t>(r3+(r2a>>32)+(r2b>>32)+(r2>>32));
+#endif
+}
+
+struct fastrange_lower_size_policy
+{
+  using size_index_type=std::size_t;
+
+  static inline std::size_t size_index(std::size_t n)
+  {
+    return n<min_size()?min_size():n;
+  }
+
+  static inline std::size_t size(std::size_t size_index_)
+  {
+     return size_index_;
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  {
+    return static_cast<std::size_t>(
+      (static_cast<std::uint64_t>(static_cast<std::uint32_t>(hash))*
+       size_index_)>>32);
+  }
+};
+
+struct fastrange_upper_size_policy
+{
+  using size_index_type=std::size_t;
+
+  static inline std::size_t size_index(std::size_t n)
+  {
+    return n<min_size()?min_size():n;
+  }
+
+  static inline std::size_t size(std::size_t size_index_)
+  {
+     return size_index_;
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static inline std::size_t position(std::size_t hash,std::size_t size_index_)
+  {
+    return mul_high(hash,size_index_);
+  }
+
+  static inline std::size_t preimage(std::size_t pos,std::size_t size_index_)
+  {
+    /* pos*ceil(2^64/n) maps to pos as long as n<2^32 */
+
+    return pos*(~std::size_t(0)/size_index_+1);
+  }
+};
+
+/* Exact modulo reduction with Lemire's fastmod
+ * (https://arxiv.org/abs/1902.01961): the lower variant takes the low 32
+ * bits of the hash modulo n, the upper variant the high 32 bits. Unlike
+ * fastrange, all the bits of the operand take part in the result.
+ */
+
+struct fastmod_size_index
+{
+  std::uint64_t m; /* ceil(2^64/n) */
+  std::size_t   n;
+};
+
+struct fastmod_lower_size_policy
+{
+  using size_index_type=fastmod_size_index;
+
+  static inline fastmod_size_index size_index(std::size_t n)
+  {
+    if(n<min_size())n=min_size();
+    return {~std::uint64_t(0)/n+1,n};
+  }
+
+  static inline std::size_t size(const fastmod_size_index& size_index_)
+  {
+     return size_index_.n;
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static inline std::size_t position(
+    std::size_t hash,const fastmod_size_index& size_index_)
+  {
+    return mul_high(
+      size_index_.m*static_cast<std::uint32_t>(hash),size_index_.n);
+  }
+};
+
+struct fastmod_upper_size_policy
+{
+  using size_index_type=fastmod_size_index;
+
+  static inline fastmod_size_index size_index(std::size_t n)
+  {
+    if(n<min_size())n=min_size();
+    return {~std::uint64_t(0)/n+1,n};
+  }
+
+  static inline std::size_t size(const fastmod_size_index& size_index_)
+  {
+     return size_index_.n;
+  }
+    
+  static constexpr std::size_t min_size(){return 2;}
+
+  static inline std::size_t position(
+    std::size_t hash,const fastmod_size_index& size_index_)
+  {
+    return mul_high(
+      size_index_.m*static_cast<std::uint32_t>(hash>>32),size_index_.n);
+  }
+
+  static inline std::size_t preimage(
+    std::size_t pos,const fastmod_size_index&)
+  {
+    return pos<<32;
+  }
+};
+
+/* n/load_factor for the non-minimal containers, load factors above 1 taken
+ * as 1. Non-positive and NaN load factors, as well as those so small that
+ * the result would not leave room for rounding up by the size policies,
+ * throw std::invalid_argument.
+ */
+
+inline std::size_t scaled_size(std::size_t n,double load_factor)
+{
+  static constexpr double max_size=
+    static_cast<double>(std::size_t(1)<<(sizeof(std::size_t)*CHAR_BIT-2));
+
+  auto res=static_cast<double>(n)/(std::min)(load_factor,1.0);
+  if(!(load_factor>0.0)||!(res<max_size)){
+    throw std::invalid_argument("load_factor out of range");
+  }
+  return static_cast<std::size_t>(res);
+}
+
+} /* namespace hd */
+
+#endif
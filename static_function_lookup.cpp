@@ -0,0 +1,222 @@
+/* Comparing keyless hd static functions against an hd::perfect_set of
+ * (key,value) pairs: construction time, memory and lookup time.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+
+std::chrono::high_resolution_clock::time_point measure_start,measure_pause;
+
+template<typename F>
+double measure(F f)
+{
+  using namespace std::chrono;
+
+  static const int              num_trials=10;
+  static const milliseconds     min_time_per_trial(200);
+  std::array<double,num_trials> trials;
+
+  for(int i=0;i<num_trials;++i){
+    int                               runs=0;
+    high_resolution_clock::time_point t2;
+    volatile decltype(f())            res; /* to avoid optimizing f() away */
+
+    measure_start=high_resolution_clock::now();
+    do{
+      res=f();
+      ++runs;
+      t2=high_resolution_clock::now();
+    }while(t2-measure_start<min_time_per_trial);
+    trials[i]=duration_cast<duration<double>>(t2-measure_start).count()/runs;
+  }
+
+  std::sort(trials.begin(),trials.end());
+  return std::accumulate(
+    trials.begin()+2,trials.end()-2,0.0)/(trials.size()-4);
+}
+
+#include <boost/core/detail/splitmix64.hpp>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "hd_perfect_set.hpp"
+#include "hd_static_function.hpp"
+#include "counting_allocator.hpp"
+
+struct splitmix64_urng:boost::detail::splitmix64
+{
+  using boost::detail::splitmix64::splitmix64;
+  using result_type=boost::uint64_t;
+
+  static constexpr result_type (min)(){return 0u;}
+  static constexpr result_type(max)()
+  {return (std::numeric_limits<result_type>::max)();}
+};
+
+struct sum_all
+{
+  using result_type=std::uint64_t;
+
+  template<typename FwdIterator,typename Container>
+  BOOST_NOINLINE result_type operator()(
+    FwdIterator first,FwdIterator last,const Container& c)const
+  {
+    std::uint64_t res=0;
+    while(first!=last)res+=c(*first++);
+    return res;
+  }
+};
+
+/* bits/elem doesn't include the out-of-line data of string elements */
+
+template<typename Data,typename Input,typename Make>
+void test(const char* name,const Data& data,const Input& success,Make make)
+{
+  std::cout<<name<<":"<<std::endl;
+  std::cout<<"n;build (ns/elem);bits/elem;lookup (ns);"<<std::endl;
+
+  unsigned int n0=1000,dn=1000;
+  double       fdn=1.5;
+  for(unsigned int n=n0;n<=data.size();n+=dn,dn=(unsigned int)(dn*fdn)){
+    auto first=data.begin(),last=data.begin()+n;
+
+    auto build=measure([&]{
+      auto s=make(first,last);
+      return s.size();
+    });
+
+    auto bytes0=allocated_bytes;
+    auto s=make(first,last);
+    auto bytes=allocated_bytes-bytes0;
+
+    auto sfirst=success.begin(),slast=success.begin()+n;
+    std::cout
+      <<n<<";"
+      <<build*1E9/n<<";"
+      <<(double)bytes*8/n<<";"
+      <<measure([&]{return sum_all{}(sfirst,slast,s);})*1E9/n<<";"
+      <<std::endl;
+  }
+}
+
+/* hd::perfect_set of (key,value) pairs hashed and compared by key */
+
+template<typename Hash>
+struct first_hash:Hash
+{
+  template<typename T,typename V>
+  std::size_t operator()(const std::pair<T,V>& x)const
+  {return Hash::operator()(x.first);}
+
+  template<typename T>
+  std::size_t operator()(const T& x)const{return Hash::operator()(x);}
+};
+
+struct first_equal_to
+{
+  template<typename T,typename V>
+  bool operator()(const std::pair<T,V>& x,const std::pair<T,V>& y)const
+  {return x.first==y.first;}
+
+  template<typename T,typename V>
+  bool operator()(const T& x,const std::pair<T,V>& y)const
+  {return x==y.first;}
+};
+
+template<typename T,typename V,typename Hash>
+struct keyed_map:hd::perfect_set<
+  std::pair<T,V>,first_hash<Hash>,first_equal_to,
+  counting_allocator<std::pair<T,V>>>
+{
+  using super=hd::perfect_set<
+    std::pair<T,V>,first_hash<Hash>,first_equal_to,
+    counting_allocator<std::pair<T,V>>>;
+  using super::super;
+  std::size_t size()const{return this->end()-this->begin();}
+  std::uint64_t operator()(const T& x)const
+  {
+    auto it=this->find(x);
+    return it!=this->end()?it->second:0;
+  }
+};
+
+template<typename T,std::size_t ValueBits,std::size_t FingerprintBits,typename Hash>
+struct static_function:hd::static_function<
+  T,ValueBits,FingerprintBits,Hash,std::equal_to<T>,counting_allocator<T>>
+{
+  using super=hd::static_function<
+    T,ValueBits,FingerprintBits,Hash,std::equal_to<T>,counting_allocator<T>>;
+  using super::super;
+  std::uint64_t operator()(const T& x)const
+  {
+    if constexpr(FingerprintBits>0)return this->find(x).value_or(0);
+    else return super::operator()(x);
+  }
+};
+
+template<typename T,std::size_t ValueBits,typename Hash,typename Data,typename Input>
+void test_all(const Data& data,const Input& success)
+{
+  std::cout<<ValueBits<<"-bit values"<<std::endl;
+  test(
+    "hd::perfect_set of pairs",data,success,
+    [](auto first,auto last){
+      return keyed_map<T,std::uint16_t,Hash>(first,last);});
+  test(
+    "hd::static_function",data,success,
+    [](auto first,auto last){
+      return static_function<T,ValueBits,0,Hash>(first,last);});
+  test(
+    "hd::static_function, 8-bit fingerprints",data,success,
+    [](auto first,auto last){
+      return static_function<T,ValueBits,8,Hash>(first,last);});
+}
+
+static std::string make_string(std::size_t x)
+{
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"pfx_%zu_sfx",x);
+  return buffer;
+}
+
+template<typename T,typename Hash,typename Make>
+void test_values(Make make_key)
+{
+  static constexpr std::size_t N=1'000'000;
+
+  std::mt19937                               gen(0);
+  std::uniform_int_distribution<std::size_t> dist;
+  std::vector<std::pair<T,std::uint16_t>>    data;
+
+  for(std::size_t i=0;i<N;++i){
+    data.push_back({make_key(dist(gen)),(std::uint16_t)(dist(gen)%4096)});
+  }
+
+  std::vector<T> success;
+  for(const auto& x:data)success.push_back(x.first);
+  std::shuffle(success.begin(),success.end(),splitmix64_urng{31321});
+
+  auto data2=data;
+  for(auto& x:data2)x.second%=4;
+  test_all<T,2,Hash>(data2,success);
+  test_all<T,12,Hash>(data,success);
+}
+
+int main()
+{
+  std::cout<<"integers"<<std::endl;
+  test_values<std::size_t,hd::mbs_hash>([](std::size_t x){return x;});
+  std::cout<<"strings"<<std::endl;
+  test_values<std::string,hd::mulxp3_string_hash>(make_string);
+}
@@ -0,0 +1,87 @@
+/* Construction time and peak heap usage of hd::perfect_set when keys
+ * are produced one at a time: collected into a vector and passed to the
+ * range constructor vs. fed to perfect_set::builder.
+ *
+ * Copyright 2023 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "allocation_counter.hpp"
+#include "hd_perfect_set.hpp"
+
+/* stand-in for a parser or socket: yields n distinct keys, then stops */
+
+struct key_source
+{
+  explicit key_source(std::size_t n_):n{n_}{}
+
+  bool next(std::string& x)
+  {
+    if(i==n)return false;
+    x="key-"+std::to_string(gen())+"-"+std::to_string(i++);
+    return true;
+  }
+
+  std::size_t  n,i=0;
+  std::mt19937 gen{0};
+};
+
+using container=hd::perfect_set<std::string,hd::mulxp3_string_hash>;
+
+template<typename F>
+void test(const char* name,std::size_t n,F f)
+{
+  auto base=allocated;
+  peak_allocated=allocated;
+  auto t=std::chrono::high_resolution_clock::now();
+  auto c=f(key_source{n});
+  auto build=std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now()-t).count();
+
+  key_source src{n};
+  for(std::string x;src.next(x);){
+    if(c.find(x)==c.end()){
+      std::cerr<<"element not found"<<std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  std::cout
+    <<n<<";"<<name<<";"<<build*1E9/n<<";"
+    <<static_cast<double>(peak_allocated-base)/n<<";"
+    <<static_cast<double>(allocated-base)/n<<";"<<std::endl;
+}
+
+int main(int argc,char* argv[])
+{
+  /* streaming_build [max_n] */
+
+  std::size_t max_n=argc>1?std::strtoull(argv[1],nullptr,10):1'000'000;
+
+  std::cout
+    <<"n;method;build (ns/elem);peak heap (bytes/elem);"
+      "final heap (bytes/elem);"<<std::endl;
+  for(std::size_t n=10'000;n<=max_n;n*=10){
+    test("range",n,[](key_source src){
+      std::vector<std::string> keys;
+      for(std::string x;src.next(x);)keys.push_back(std::move(x));
+      return container(keys.begin(),keys.end());
+    });
+    test("builder",n,[](key_source src){
+      container::builder b;
+      for(std::string x;src.next(x);)b.add(std::move(x));
+      return b.finalize();
+    });
+  }
+}